@@ -0,0 +1,404 @@
+/*
+ * Asynchronous batched error logger.
+ *
+ * correct_lab2.c sends its diagnostics to errors.log by dup2()ing an O_APPEND
+ * descriptor over stdout/stderr, so every perror()/fprintf(stderr) becomes a
+ * synchronous, unbuffered write() to disk on the caller's path. This logger
+ * takes the disk out of the caller's path:
+ *   - callers format into a per-thread buffer and copy the finished line into
+ *     a record,
+ *   - records are pushed onto a lock-free multi-producer/single-consumer
+ *     queue (one atomic exchange per push),
+ *   - one background thread drains the queue and writes up to 256 records
+ *     per writev() call,
+ *   - when the file would grow past a size limit it is rotated:
+ *     errors.log -> errors.log.1 -> ... -> errors.log.<keep>.
+ *
+ * Interface: alog_init(), alog_printf(), alog_perror(), alog_shutdown()
+ *
+ * Usage: ./async_logger [-t threads] [-n messages_each] [-s max_KB] [-k keep] [-S] [file]
+ *   -S  compare with the old way: one synchronous O_APPEND write() per message
+ * Build: gcc -O2 -pthread async_logger.c -o async_logger
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#define LOG_LINE_MAX   4096             // longest formatted message
+#define BATCH_MAX      256              // records per writev()
+#define DEFAULT_MAX_KB (10 * 1024)      // rotate at 10MB
+#define DEFAULT_KEEP   3                // rotated files kept
+
+// One formatted log line
+typedef struct log_rec {
+    struct log_rec *next;
+    size_t len;
+    char text[];
+} log_rec;
+
+// Intrusive MPSC queue (Vyukov): producers swap themselves in at head,
+// the single consumer follows next pointers from tail
+typedef struct {
+    log_rec *head;        // last pushed record (producers)
+    log_rec *tail;        // next record to pop (consumer only)
+    log_rec stub;         // placeholder that keeps the list non-empty
+} mpsc_queue;
+
+static struct {
+    mpsc_queue q;
+    int fd;
+    char path[4096];
+    off_t size;           // current file size
+    off_t max_size;
+    int keep;
+    pthread_t thread;
+    int stop;
+    int wake;             // futex word: bumped when the consumer may be asleep
+    int sleeping;         // consumer is (about to be) waiting on wake
+    unsigned long written, rotations;
+} logger;
+
+static __thread char tls_buf[LOG_LINE_MAX];
+
+static void queue_init(mpsc_queue *q) {
+    q->stub.next = NULL;
+    q->head = &q->stub;
+    q->tail = &q->stub;
+}
+
+static void queue_push(mpsc_queue *q, log_rec *r) {
+    r->next = NULL;
+    log_rec *prev = __atomic_exchange_n(&q->head, r, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&prev->next, r, __ATOMIC_RELEASE);
+}
+
+// Pop the oldest record, or NULL when empty (or a push is half done)
+static log_rec *queue_pop(mpsc_queue *q) {
+    log_rec *tail = q->tail;
+    log_rec *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (tail == &q->stub) {
+        if (next == NULL) return NULL;
+        q->tail = next;
+        tail = next;
+        next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+    }
+    if (next) {
+        q->tail = next;
+        return tail;
+    }
+    if (tail != __atomic_load_n(&q->head, __ATOMIC_ACQUIRE)) return NULL;
+    queue_push(q, &q->stub);
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (next) {
+        q->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+static void futex_wait(int *addr, int val) {
+    struct timespec timeout = { 0, 50 * 1000 * 1000 };  // re-check every 50ms regardless
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, &timeout, NULL, 0);
+}
+
+static void futex_wake(int *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+/* -------------------------------------------
+   Background writer
+   ------------------------------------------- */
+
+static int open_log(void) {
+    logger.fd = open(logger.path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (logger.fd < 0) return -1;
+    logger.size = lseek(logger.fd, 0, SEEK_END);
+    return 0;
+}
+
+// errors.log.(keep-1) -> errors.log.keep, ..., errors.log -> errors.log.1
+static void rotate_log(void) {
+    char from[4200], to[4200];
+    close(logger.fd);
+    for (int i = logger.keep - 1; i >= 0; i--) {
+        if (i == 0) {
+            snprintf(from, sizeof(from), "%s", logger.path);
+        } else {
+            snprintf(from, sizeof(from), "%s.%d", logger.path, i);
+        }
+        snprintf(to, sizeof(to), "%s.%d", logger.path, i + 1);
+        rename(from, to);  // missing files are fine
+    }
+    if (logger.keep == 0) unlink(logger.path);
+    if (open_log() == -1) {
+        perror("Error reopening log after rotation");
+        exit(EXIT_FAILURE);
+    }
+    logger.rotations++;
+}
+
+// writev() the batch, resuming after short writes; records are freed after
+static void write_batch(log_rec **batch, int n, size_t bytes) {
+    if (logger.max_size > 0 && logger.size > 0 && logger.size + (off_t)bytes > logger.max_size) {
+        rotate_log();
+    }
+    struct iovec iov[BATCH_MAX];
+    for (int i = 0; i < n; i++) {
+        iov[i].iov_base = batch[i]->text;
+        iov[i].iov_len = batch[i]->len;
+    }
+    struct iovec *v = iov;
+    int cnt = n;
+    while (cnt > 0) {
+        ssize_t w = writev(logger.fd, v, cnt);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            break;  // nowhere left to report this; drop the batch
+        }
+        logger.size += w;
+        while (cnt > 0 && (size_t)w >= v->iov_len) {
+            w -= v->iov_len;
+            v++;
+            cnt--;
+        }
+        if (cnt > 0) {
+            v->iov_base = (char *)v->iov_base + w;
+            v->iov_len -= w;
+        }
+    }
+    logger.written += n;
+    for (int i = 0; i < n; i++) free(batch[i]);
+}
+
+static void *writer_thread(void *arg) {
+    (void)arg;
+    log_rec *batch[BATCH_MAX];
+    for (;;) {
+        int n = 0;
+        size_t bytes = 0;
+        log_rec *r;
+        while (n < BATCH_MAX && (r = queue_pop(&logger.q)) != NULL) {
+            batch[n++] = r;
+            bytes += r->len;
+        }
+        if (n > 0) {
+            write_batch(batch, n, bytes);
+            continue;
+        }
+        if (__atomic_load_n(&logger.stop, __ATOMIC_ACQUIRE)) {
+            // Drain anything pushed right before stop was set
+            if (__atomic_load_n(&logger.q.head, __ATOMIC_ACQUIRE) == logger.q.tail &&
+                logger.q.tail == &logger.q.stub) {
+                break;
+            }
+            continue;
+        }
+        // Queue empty: announce we are going to sleep, re-check, then wait
+        int seen = __atomic_load_n(&logger.wake, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&logger.sleeping, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&logger.q.stub.next, __ATOMIC_SEQ_CST) == NULL &&
+            logger.q.tail == &logger.q.stub &&
+            !__atomic_load_n(&logger.stop, __ATOMIC_ACQUIRE)) {
+            futex_wait(&logger.wake, seen);
+        }
+        __atomic_store_n(&logger.sleeping, 0, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/* -------------------------------------------
+   Public interface
+   ------------------------------------------- */
+
+// Start the logger. max_size 0 disables rotation.
+int alog_init(const char *path, off_t max_size, int keep) {
+    memset(&logger, 0, sizeof(logger));
+    snprintf(logger.path, sizeof(logger.path), "%s", path);
+    logger.max_size = max_size;
+    logger.keep = keep;
+    queue_init(&logger.q);
+    if (open_log() == -1) return -1;
+    if (pthread_create(&logger.thread, NULL, writer_thread, NULL) != 0) {
+        close(logger.fd);
+        return -1;
+    }
+    return 0;
+}
+
+// Queue one finished line (already formatted in tls_buf)
+static void alog_enqueue(const char *text, size_t len) {
+    log_rec *r = malloc(sizeof(log_rec) + len);
+    if (!r) return;  // out of memory: drop the message rather than block
+    memcpy(r->text, text, len);
+    r->len = len;
+    queue_push(&logger.q, r);
+    // Pairs with the writer's store of sleeping and re-check of the queue:
+    // the link store must be visible before sleeping is read, or both sides
+    // can miss each other (a release store may still sit in the store buffer)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&logger.sleeping, __ATOMIC_SEQ_CST)) {
+        __atomic_fetch_add(&logger.wake, 1, __ATOMIC_RELEASE);
+        futex_wake(&logger.wake);
+    }
+}
+
+// Format "[date time.ms] LEVEL: message\n" into tls_buf; returns its length.
+// localtime_r() takes a global lock, so the date part is cached per thread
+// and only rebuilt when the second changes.
+static size_t format_line(const char *level, const char *fmt, va_list ap) {
+    static __thread time_t cached_sec = -1;
+    static __thread char cached_date[32];
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    if (ts.tv_sec != cached_sec) {
+        struct tm tm;
+        localtime_r(&ts.tv_sec, &tm);
+        strftime(cached_date, sizeof(cached_date), "%Y-%m-%d %H:%M:%S", &tm);
+        cached_sec = ts.tv_sec;
+    }
+    int n = snprintf(tls_buf, LOG_LINE_MAX, "[%s.%03ld] %s: ", cached_date,
+                     ts.tv_nsec / 1000000, level);
+    n += vsnprintf(tls_buf + n, LOG_LINE_MAX - n, fmt, ap);
+    if (n >= LOG_LINE_MAX) n = LOG_LINE_MAX - 1;  // truncated
+    if (tls_buf[n - 1] != '\n') {
+        if (n == LOG_LINE_MAX - 1) n--;
+        tls_buf[n++] = '\n';
+    }
+    return (size_t)n;
+}
+
+// printf-style log line with a timestamp and level prefix; never touches disk
+void alog_printf(const char *level, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    size_t n = format_line(level, fmt, ap);
+    va_end(ap);
+    alog_enqueue(tls_buf, n);
+}
+
+// Drop-in for perror(): "msg: strerror(errno)"
+void alog_perror(const char *msg) {
+    int err = errno;
+    char buf[256];
+    alog_printf("ERROR", "%s: %s", msg, strerror_r(err, buf, sizeof(buf)) == 0 ? buf : "unknown error");
+    errno = err;
+}
+
+// Flush every queued line and stop the background thread
+void alog_shutdown(void) {
+    __atomic_store_n(&logger.stop, 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&logger.wake, 1, __ATOMIC_RELEASE);
+    futex_wake(&logger.wake);
+    pthread_join(logger.thread, NULL);
+    fsync(logger.fd);
+    close(logger.fd);
+}
+
+/* -------------------------------------------
+   Demo: error-heavy threads
+   ------------------------------------------- */
+
+static long messages = 100000;
+static int sync_fd = -1;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The old path: same formatting, then one synchronous write() per message
+static void sync_printf(const char *level, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    size_t n = format_line(level, fmt, ap);
+    va_end(ap);
+    if (write(sync_fd, tls_buf, n) == -1) perror("Error writing log");
+}
+
+static void *error_heavy(void *arg) {
+    long id = (long)arg;
+    for (long i = 0; i < messages; i++) {
+        if (sync_fd >= 0) {
+            sync_printf("ERROR", "An error occurred: thread %ld request %ld failed", id, i);
+        } else {
+            alog_printf("ERROR", "An error occurred: thread %ld request %ld failed", id, i);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int threads = 4, keep = DEFAULT_KEEP, compare_sync = 0;
+    off_t max_size = (off_t)DEFAULT_MAX_KB * 1024;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:n:s:k:S")) != -1) {
+        switch (opt) {
+        case 't': threads = atoi(optarg); break;
+        case 'n': messages = atol(optarg); break;
+        case 's': max_size = (off_t)strtoll(optarg, NULL, 10) * 1024; break;
+        case 'k': keep = atoi(optarg); break;
+        case 'S': compare_sync = 1; break;
+        default:
+            fprintf(stderr, "Usage: ./async_logger [-t threads] [-n messages_each] [-s max_KB] [-k keep] [-S] [file]\n");
+            return 1;
+        }
+    }
+    if (threads < 1 || keep < 0) {
+        fprintf(stderr, "Need at least one thread and a non-negative keep count\n");
+        return 1;
+    }
+    const char *path = optind < argc ? argv[optind] : "errors.log";
+
+    if (compare_sync) {
+        sync_fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (sync_fd < 0) {
+            perror("Error opening log file");
+            return 1;
+        }
+    } else if (alog_init(path, max_size, keep) == -1) {
+        perror("Error starting logger");
+        return 1;
+    }
+
+    pthread_t tid[threads];
+    double start = now_seconds();
+    for (long i = 0; i < threads; i++) {
+        if (pthread_create(&tid[i], NULL, error_heavy, (void *)i) != 0) {
+            fprintf(stderr, "Error creating thread\n");
+            return 1;
+        }
+    }
+    for (int i = 0; i < threads; i++) pthread_join(tid[i], NULL);
+    double callers = now_seconds() - start;
+
+    if (compare_sync) {
+        close(sync_fd);
+    } else {
+        if (open("does_not_exist.txt", O_RDONLY) == -1) {
+            alog_perror("Error opening does_not_exist.txt");
+        }
+        alog_shutdown();
+    }
+    double total = now_seconds() - start;
+
+    long n = messages * threads;
+    printf("%s: %ld messages from %d threads\n",
+           compare_sync ? "Synchronous write()" : "Async logger", n, threads);
+    printf("  time spent in callers: %.3f s (%.0f ns per message)\n", callers, callers * 1e9 / n);
+    printf("  time until on disk:    %.3f s\n", total);
+    if (!compare_sync) {
+        printf("  lines written: %lu, rotations: %lu\n", logger.written, logger.rotations);
+    }
+    return 0;
+}
@@ -0,0 +1,388 @@
+/*
+ * Memory-mapped circular log file with lock-free multi-producer append.
+ *
+ * circular_seek() in correct_lab2.c and part2_circular() in lab2.c move a file
+ * pointer around a file with (pos + step) % file_size, one lseek() and a
+ * 1-byte write() per step. This program builds a real fixed-size journal on
+ * the same idea:
+ *   - the file is a 4KB header page followed by a data ring of fixed size,
+ *     and the whole file is mmap()ed, so appending is a memcpy() into memory,
+ *   - the header holds head (next byte to reserve, counted from the start of
+ *     time, so it never wraps) and tail (how far a consumer has read),
+ *   - producers reserve space with one atomic fetch-add on head, no lock,
+ *   - every record is framed as [length][CRC32C][logical offset][payload],
+ *     padded to 16 bytes; the logical offset is stored last, so a record is
+ *     only visible once it is complete,
+ *   - old records are overwritten when the ring laps, so disk use is bounded,
+ *   - readers (and crash recovery) walk from max(tail, head - ring size) and
+ *     accept a record only if its stored logical offset equals its position
+ *     and its CRC matches, skipping forward 16 bytes at a time over torn or
+ *     never-finished records.
+ *
+ * Usage: ./circular_log [-s ring_KB] [-p producers] [-n records_each] file   write test records
+ *        ./circular_log -r file                                           read back / recover
+ * Build: gcc -O2 -pthread circular_log.c -o circular_log   (add -msse4.2 for hardware CRC)
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#define LOG_MAGIC        0x474F4C435249434BULL  // "KCIRCLOG"
+#define HEADER_SIZE      4096
+#define RECORD_ALIGN     16
+#define REC_HDR_SIZE     16
+#define SKIP_RECORD      0xFFFFFFFFu   // length marking "rest of the ring is unused"
+#define MAX_RECORD       (64 * 1024)
+#define DEFAULT_RING_KB  1024
+
+// File header; head and tail sit on separate cache lines
+typedef struct {
+    uint64_t magic;
+    uint64_t capacity;                      // bytes in the data ring
+    char     pad0[48];
+    uint64_t head __attribute__((aligned(64)));   // next logical byte to reserve
+    char     pad1[56];
+    uint64_t tail __attribute__((aligned(64)));   // consumer position
+} log_header;
+
+// Frame in front of every record
+typedef struct {
+    uint32_t len;     // payload bytes, or SKIP_RECORD
+    uint32_t crc;     // CRC32C of the payload and lpos; for SKIP_RECORD the bytes reserved
+    uint64_t lpos;    // logical offset of this record; written last
+} rec_header;
+
+typedef struct {
+    int fd;
+    size_t map_size;
+    log_header *hdr;
+    char *ring;
+    uint64_t capacity;
+} circ_log;
+
+/* -------------------------------------------
+   CRC32C
+   ------------------------------------------- */
+
+static uint32_t crc_table[256];
+
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1)));
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t crc32c(uint32_t crc, const void *data, size_t len) {
+    const unsigned char *p = data;
+    crc = ~crc;
+#if defined(__SSE4_2__)
+    for (; len >= 8; len -= 8, p += 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        crc = (uint32_t)_mm_crc32_u64(crc, v);
+    }
+    for (; len > 0; len--) crc = _mm_crc32_u8(crc, *p++);
+#else
+    for (; len > 0; len--) crc = crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+#endif
+    return ~crc;
+}
+
+static uint32_t record_crc(const void *payload, uint32_t len, uint64_t lpos) {
+    return crc32c(crc32c(0, &lpos, sizeof(lpos)), payload, len);
+}
+
+static uint64_t record_size(uint32_t len) {
+    return (REC_HDR_SIZE + (uint64_t)len + RECORD_ALIGN - 1) & ~(uint64_t)(RECORD_ALIGN - 1);
+}
+
+/* -------------------------------------------
+   Open / close
+   ------------------------------------------- */
+
+// Gives up on a half-opened log, keeping errno
+static int clog_fail(circ_log *log) {
+    int saved = errno;
+    close(log->fd);
+    log->fd = -1;
+    errno = saved;
+    return -1;
+}
+
+// Open a log, or with create also make one with the given ring capacity.
+// Only a missing or empty file is initialised; an existing file must carry a
+// valid header (EINVAL otherwise, and it is left untouched) and keeps its
+// records and its own capacity.
+int clog_open(circ_log *log, const char *path, uint64_t capacity, int create) {
+    capacity &= ~(uint64_t)(RECORD_ALIGN - 1);
+    log->fd = open(path, O_RDWR | (create ? O_CREAT : 0), 0644);
+    if (log->fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(log->fd, &st) == -1) return clog_fail(log);
+    int fresh = st.st_size == 0;
+    if (fresh && !create) {
+        errno = EINVAL;
+        return clog_fail(log);
+    }
+    if (!fresh) {
+        log_header existing;
+        if (st.st_size < HEADER_SIZE ||
+            pread(log->fd, &existing, sizeof(existing), 0) != (ssize_t)sizeof(existing) ||
+            existing.magic != LOG_MAGIC || (uint64_t)st.st_size != HEADER_SIZE + existing.capacity) {
+            errno = EINVAL;
+            return clog_fail(log);
+        }
+        capacity = existing.capacity;
+    }
+    if (capacity < 2 * MAX_RECORD) {
+        errno = EINVAL;
+        return clog_fail(log);
+    }
+    if (fresh && ftruncate(log->fd, HEADER_SIZE + capacity) == -1) return clog_fail(log);
+
+    log->map_size = HEADER_SIZE + capacity;
+    void *map = mmap(NULL, log->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, 0);
+    if (map == MAP_FAILED) return clog_fail(log);
+    log->hdr = map;
+    log->ring = (char *)map + HEADER_SIZE;
+    log->capacity = capacity;
+    if (fresh) {
+        log->hdr->capacity = capacity;
+        log->hdr->head = 0;
+        log->hdr->tail = 0;
+        __atomic_store_n(&log->hdr->magic, LOG_MAGIC, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+
+// Push dirty pages to disk (optional; the kernel writes them back anyway)
+int clog_sync(circ_log *log) {
+    return msync(log->hdr, log->map_size, MS_SYNC);
+}
+
+void clog_close(circ_log *log) {
+    munmap(log->hdr, log->map_size);
+    close(log->fd);
+}
+
+/* -------------------------------------------
+   Append (lock-free, any number of producers)
+   ------------------------------------------- */
+
+// Append one record; returns its logical offset, or -1 if it is too large
+int64_t clog_append(circ_log *log, const void *data, uint32_t len) {
+    if (len > MAX_RECORD) return -1;
+    uint64_t size = record_size(len);
+    for (;;) {
+        uint64_t pos = __atomic_fetch_add(&log->hdr->head, size, __ATOMIC_ACQ_REL);
+        uint64_t phys = pos % log->capacity;
+        rec_header *rh = (rec_header *)(log->ring + phys);
+
+        if (phys + size > log->capacity) {
+            // Would run past the end: mark the rest of the ring unused and
+            // reserve again (the next reservation starts at or after offset 0).
+            // The size lets readers step over the part that spilled past the
+            // start of the ring instead of taking it for torn records.
+            rh->len = SKIP_RECORD;
+            rh->crc = (uint32_t)size;
+            __atomic_store_n(&rh->lpos, pos, __ATOMIC_RELEASE);
+            continue;
+        }
+
+        // Fill in the frame, then publish it by storing lpos. Whatever was
+        // here before carries an older lpos, so readers cannot mistake it
+        // for this record.
+        memcpy(rh + 1, data, len);
+        rh->len = len;
+        rh->crc = record_crc(data, len, pos);
+        __atomic_store_n(&rh->lpos, pos, __ATOMIC_RELEASE);
+        return (int64_t)pos;
+    }
+}
+
+/* -------------------------------------------
+   Read / recovery
+   ------------------------------------------- */
+
+// Called for every valid record in order
+typedef void (*record_fn)(uint64_t lpos, const char *data, uint32_t len, void *ctx);
+
+// Walk every readable record from the consumer position (or the oldest data
+// still in the ring) up to head. Returns the number of records delivered and
+// stores the number of skipped (torn/overwritten) bytes in *skipped. Wrap
+// padding and the remains of the record the newest lap cut in half at the
+// oldest end of the ring are part of a healthy log and are not counted.
+size_t clog_read(circ_log *log, record_fn fn, void *ctx, uint64_t *skipped) {
+    char *copy = malloc(MAX_RECORD);
+    if (!copy) return 0;
+    uint64_t head = __atomic_load_n(&log->hdr->head, __ATOMIC_ACQUIRE);
+    uint64_t pos = __atomic_load_n(&log->hdr->tail, __ATOMIC_ACQUIRE);
+    int lapped = 0;  // starting mid-way through an overwritten record
+    if (head > log->capacity && pos < head - log->capacity) {
+        pos = head - log->capacity;
+        lapped = 1;
+    }
+    pos = (pos + RECORD_ALIGN - 1) & ~(uint64_t)(RECORD_ALIGN - 1);
+
+    size_t count = 0;
+    *skipped = 0;
+    while (pos + REC_HDR_SIZE <= head) {
+        uint64_t phys = pos % log->capacity;
+        rec_header *rh = (rec_header *)(log->ring + phys);
+        uint64_t lpos = __atomic_load_n(&rh->lpos, __ATOMIC_ACQUIRE);
+        uint32_t len = rh->len;
+
+        if (lpos == pos && len == SKIP_RECORD) {
+            // Wrap padding, not data: jump past its whole reservation (at
+            // least to the start of the ring) without counting it as skipped
+            uint64_t reserved = rh->crc;
+            if (reserved > record_size(MAX_RECORD)) reserved = 0;
+            pos += reserved > log->capacity - phys ? reserved : log->capacity - phys;
+            lapped = 0;
+            continue;
+        }
+        if (lpos != pos || len > MAX_RECORD || phys + record_size(len) > log->capacity) {
+            // Not a finished record for this lap: resynchronize
+            pos += RECORD_ALIGN;
+            if (!lapped) *skipped += RECORD_ALIGN;
+            continue;
+        }
+        lapped = 0;
+
+        memcpy(copy, rh + 1, len);
+        uint32_t crc = rh->crc;
+        // Seqlock-style check: the copy is good only if no producer has since
+        // reserved space that reaches back over this record
+        uint64_t head_now = __atomic_load_n(&log->hdr->head, __ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&rh->lpos, __ATOMIC_ACQUIRE) != pos ||
+            head_now > pos + log->capacity || record_crc(copy, len, pos) != crc) {
+            pos += RECORD_ALIGN;
+            *skipped += RECORD_ALIGN;
+            continue;
+        }
+        if (fn) fn(pos, copy, len, ctx);
+        count++;
+        pos += record_size(len);
+    }
+    free(copy);
+    return count;
+}
+
+// Mark everything up to pos as consumed
+void clog_consume(circ_log *log, uint64_t pos) {
+    __atomic_store_n(&log->hdr->tail, pos, __ATOMIC_RELEASE);
+}
+
+/* -------------------------------------------
+   Demo
+   ------------------------------------------- */
+
+typedef struct {
+    circ_log *log;
+    int id;
+    long records;
+} producer_arg;
+
+static void *producer(void *arg) {
+    producer_arg *a = arg;
+    char msg[128];
+    for (long i = 0; i < a->records; i++) {
+        int n = snprintf(msg, sizeof(msg), "producer %d record %ld", a->id, i);
+        clog_append(a->log, msg, (uint32_t)n);
+    }
+    return NULL;
+}
+
+typedef struct {
+    size_t shown;
+    uint64_t last;
+} dump_ctx;
+
+static void print_record(uint64_t lpos, const char *data, uint32_t len, void *arg) {
+    dump_ctx *d = arg;
+    d->last = lpos;
+    if (d->shown++ < 10) printf("  @%-12llu %.*s\n", (unsigned long long)lpos, (int)len, data);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t ring_kb = DEFAULT_RING_KB;
+    int producers = 4, read_only = 0;
+    long records = 100000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:p:n:r")) != -1) {
+        switch (opt) {
+        case 's': ring_kb = strtoull(optarg, NULL, 10); break;
+        case 'p': producers = atoi(optarg); break;
+        case 'n': records = atol(optarg); break;
+        case 'r': read_only = 1; break;
+        default:
+            fprintf(stderr, "Usage: ./circular_log [-s ring_KB] [-p producers] [-n records_each] file\n"
+                            "       ./circular_log -r file\n");
+            return 1;
+        }
+    }
+    if (optind >= argc || producers < 1) {
+        fprintf(stderr, "Usage: ./circular_log [-s ring_KB] [-p producers] [-n records_each] file\n");
+        return 1;
+    }
+    crc_init();
+
+    circ_log log;
+    if (clog_open(&log, argv[optind], ring_kb * 1024, !read_only) == -1) {
+        perror("Error opening circular log");
+        return 1;
+    }
+
+    if (!read_only) {
+        pthread_t tid[producers];
+        producer_arg args[producers];
+        double start = now_seconds();
+        for (int i = 0; i < producers; i++) {
+            args[i] = (producer_arg){ &log, i, records };
+            if (pthread_create(&tid[i], NULL, producer, &args[i]) != 0) {
+                fprintf(stderr, "Error creating producer thread\n");
+                return 1;
+            }
+        }
+        for (int i = 0; i < producers; i++) pthread_join(tid[i], NULL);
+        double elapsed = now_seconds() - start;
+        long total = records * producers;
+        printf("Appended %ld records from %d producers in %.3f s (%.0f ns/record)\n",
+               total, producers, elapsed, elapsed * 1e9 / total);
+    }
+
+    dump_ctx d = {0, 0};
+    uint64_t skipped;
+    printf("Ring: %llu KB, head at %llu, tail at %llu. Oldest records:\n",
+           (unsigned long long)(log.capacity / 1024), (unsigned long long)log.hdr->head,
+           (unsigned long long)log.hdr->tail);
+    size_t valid = clog_read(&log, print_record, &d, &skipped);
+    printf("%zu valid record(s) recovered, %llu byte(s) skipped as torn or overwritten\n",
+           valid, (unsigned long long)skipped);
+
+    clog_sync(&log);
+    clog_close(&log);
+    return 0;
+}
@@ -0,0 +1,628 @@
+/*
+ * Disk-scheduling simulator: FCFS, SSTF, SCAN, LOOK, C-SCAN and C-LOOK.
+ *
+ * os_hw4.py sorts a static list of 1000 requests in Python, always sweeps
+ * toward cylinder 0 first and has no SSTF or LOOK. This engine replays a
+ * request stream in arrival order instead:
+ *   - requests arrive over time (a synthetic Poisson stream or a trace
+ *     file); at every decision the scheduler only sees requests that have
+ *     already arrived, and an idle disk waits for the next arrival,
+ *   - the pending requests live in a 64-ary bitmap over the cylinders with a
+ *     FIFO per cylinder, so the nearest request above or below the head is
+ *     found in O(log64 cylinders) and SSTF/SCAN/LOOK never scan the queue,
+ *   - the stream is generated or read on the fly, so memory only grows with
+ *     the number of pending requests, not the trace length (100M+ requests).
+ * Time is counted in cylinders of head travel (plus -s per request), so with
+ * all requests arriving at time 0 the results match os_hw4.py: its "SCAN"
+ * turns at the last request (LOOK here) and its C-SCAN jump is not counted.
+ *
+ * Total head movement says nothing about how long a single request waits,
+ * so every policy also runs against a service-time model (-M):
+ *   units  one time unit per cylinder travelled plus -s (the default above)
+ *   hdd    seek curve: grows with the square root of the distance up to a
+ *          knee at 30% of the stroke, linearly after it, from the
+ *          track-to-track to the full-stroke time (-k t2t,full in ms); plus
+ *          a random rotational delay (-R rpm), size / transfer rate (-X MB/s)
+ *          and -s ms of controller overhead
+ *   ssd    no positioning cost: -Q channels each serve one request in
+ *          -L ms + size / -X; the policy only decides the dispatch order
+ * The response time (completion - arrival) of every request goes into a
+ * log-linear histogram, so p50/p99/p99.9 take fixed memory at any trace
+ * length and starvation shows up in the tail. hdd/ssd times are in ms and
+ * also give IOPS and MB/s.
+ *
+ * Usage: ./disk_sched [-n requests] [-C max_cylinder] [-a mean_gap] [-s service]
+ *                     [-t trace_file] [-p policy,...] [-d up|down] [-j] [-S seed]
+ *                     [-M units|hdd|ssd] [-k t2t,full] [-R rpm] [-X MB/s] [-L ms]
+ *                     [-Q channels] [-b bytes] [initial_head]
+ *   -a  mean time between arrivals (0 = everything arrives at time 0)
+ *   -t  text trace, one "arrival_time cylinder [bytes]" line per request,
+ *       sorted by time (-b is the size when bytes is missing)
+ *   -j  count the return sweep of C-SCAN/C-LOOK as head movement
+ * Build: gcc -O2 disk_sched.c -o disk_sched -lm
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_REQUESTS 1000
+#define DEFAULT_MAX_CYL  9999
+#define DEFAULT_HEAD     5000
+#define DEFAULT_SIZE     4096
+#define MAX_CHANNELS     256
+#define MAX_CYLINDERS    (1u << 24)  // per-cylinder FIFO heads cost 8 bytes each
+#define MAX_LEVELS       6
+#define NONE             UINT32_MAX
+
+enum policy { P_FCFS, P_SSTF, P_SCAN, P_LOOK, P_CSCAN, P_CLOOK, P_COUNT };
+enum model { M_UNITS, M_HDD, M_SSD };
+
+static const char *policy_names[P_COUNT] = { "FCFS", "SSTF", "SCAN", "LOOK", "C-SCAN", "C-LOOK" };
+
+/* -------------------------------------------
+   Ordered cylinder set (64-ary bitmap)
+   ------------------------------------------- */
+
+// bits[0] has one bit per cylinder; every bit of bits[l + 1] says whether
+// the matching word of bits[l] is non-zero
+typedef struct {
+    int levels;
+    uint64_t *bits[MAX_LEVELS];
+    size_t words[MAX_LEVELS];
+} cyl_set;
+
+static int cyl_set_init(cyl_set *s, uint64_t n) {
+    s->levels = 0;
+    do {
+        size_t w = (n + 63) / 64;
+        s->bits[s->levels] = calloc(w, sizeof(uint64_t));
+        if (!s->bits[s->levels]) return -1;
+        s->words[s->levels++] = w;
+        n = w;
+    } while (n > 1);
+    return 0;
+}
+
+static void cyl_set_free(cyl_set *s) {
+    for (int l = 0; l < s->levels; l++) free(s->bits[l]);
+}
+
+static void cyl_set_add(cyl_set *s, uint64_t x) {
+    for (int l = 0; l < s->levels; l++) {
+        uint64_t old = s->bits[l][x >> 6];
+        s->bits[l][x >> 6] = old | 1ULL << (x & 63);
+        if (old) break;  // upper levels already know this word is non-empty
+        x >>= 6;
+    }
+}
+
+static void cyl_set_remove(cyl_set *s, uint64_t x) {
+    for (int l = 0; l < s->levels; l++) {
+        s->bits[l][x >> 6] &= ~(1ULL << (x & 63));
+        if (s->bits[l][x >> 6]) break;
+        x >>= 6;
+    }
+}
+
+// Smallest member >= x, or -1
+static int64_t cyl_set_next(const cyl_set *s, uint64_t x) {
+    int l = 0;
+    for (;;) {
+        if (l == s->levels || (x >> 6) >= s->words[l]) return -1;
+        uint64_t m = s->bits[l][x >> 6] & (~0ULL << (x & 63));
+        if (m) {
+            x = (x & ~63ULL) | __builtin_ctzll(m);
+            break;
+        }
+        x = (x >> 6) + 1;
+        l++;
+    }
+    while (l-- > 0) x = x << 6 | __builtin_ctzll(s->bits[l][x]);
+    return (int64_t)x;
+}
+
+// Largest member <= x, or -1
+static int64_t cyl_set_prev(const cyl_set *s, uint64_t x) {
+    int l = 0;
+    for (;;) {
+        if (l == s->levels) return -1;
+        uint64_t m = s->bits[l][x >> 6] & (~0ULL >> (63 - (x & 63)));
+        if (m) {
+            x = (x & ~63ULL) | (63 - __builtin_clzll(m));
+            break;
+        }
+        if ((x >> 6) == 0) return -1;
+        x = (x >> 6) - 1;
+        l++;
+    }
+    while (l-- > 0) x = x << 6 | (63 - __builtin_clzll(s->bits[l][x]));
+    return (int64_t)x;
+}
+
+/* -------------------------------------------
+   Request source (synthetic stream or trace)
+   ------------------------------------------- */
+
+typedef struct {
+    FILE *trace;         // NULL: synthetic stream
+    uint64_t remaining;  // synthetic requests left
+    uint64_t rng;
+    double mean_gap;
+    double clock;
+    uint32_t max_cyl;
+    uint32_t default_size;
+    uint64_t line;
+    int have;            // one request of lookahead
+    double arrival;
+    uint32_t cyl;
+    uint32_t size;
+} req_source;
+
+static uint64_t xorshift64(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *s = x;
+}
+
+// Make the next request visible in src->arrival/src->cyl; 0 at the end
+static int source_peek(req_source *src) {
+    if (src->have) return 1;
+    if (!src->trace) {
+        if (src->remaining == 0) return 0;
+        src->remaining--;
+        if (src->mean_gap > 0) {
+            double u = (xorshift64(&src->rng) >> 11) * 0x1.0p-53;
+            src->clock += -src->mean_gap * log1p(-u);  // exponential gap: Poisson arrivals
+        }
+        src->arrival = src->clock;
+        src->cyl = (uint32_t)(xorshift64(&src->rng) % ((uint64_t)src->max_cyl + 1));
+        src->size = src->default_size;
+        return src->have = 1;
+    }
+
+    char buf[256];
+    while (fgets(buf, sizeof(buf), src->trace)) {
+        src->line++;
+        char *end;
+        double t = strtod(buf, &end);
+        if (end == buf) continue;  // blank or comment line
+        unsigned long long c = strtoull(end, &end, 10);
+        char *size_end;
+        unsigned long long size = strtoull(end, &size_end, 10);
+        if (size_end == end) size = src->default_size;
+        if (c > src->max_cyl || t < src->clock || size > UINT32_MAX) {
+            fprintf(stderr, "Trace line %llu: %s\n", (unsigned long long)src->line,
+                    c > src->max_cyl     ? "cylinder beyond -C"
+                    : size > UINT32_MAX ? "request size too large"
+                                        : "arrival times must not go backwards");
+            exit(EXIT_FAILURE);
+        }
+        src->clock = src->arrival = t;
+        src->cyl = (uint32_t)c;
+        src->size = (uint32_t)size;
+        return src->have = 1;
+    }
+    return 0;
+}
+
+/* -------------------------------------------
+   Service-time model
+   ------------------------------------------- */
+
+typedef struct {
+    enum model kind;
+    double t2t, full;       // hdd: track-to-track and full-stroke seek (ms)
+    double span;            // cylinders in a full stroke
+    double knee, knee_g;    // hdd: where the sqrt part ends and its share of the curve there
+    double rev_ms;          // hdd: one revolution
+    double ms_per_byte;     // transfer rate
+    double latency;         // ssd: fixed cost per request (ms)
+    int channels;           // requests in service at once
+} disk_model;
+
+// Seek time for a distance of d cylinders. The two parts of the hdd curve
+// meet with the same slope at the knee: g(d) = knee_g * sqrt(d / knee)
+// below it, a straight line from knee_g to 1 (full stroke) above it.
+static double seek_time(const disk_model *m, uint64_t d) {
+    if (m->kind == M_UNITS) return (double)d;
+    if (m->kind == M_SSD || d == 0) return 0;
+    double g = d <= m->knee ? m->knee_g * sqrt(d / m->knee)
+                            : m->knee_g + (1 - m->knee_g) * (d - m->knee) / (m->span - m->knee);
+    return m->t2t + (m->full - m->t2t) * g;
+}
+
+// Everything after positioning: rotation and transfer, or the ssd latency
+static double access_time(const disk_model *m, uint32_t size, uint64_t *rng) {
+    switch (m->kind) {
+    case M_HDD:
+        return m->rev_ms * ((xorshift64(rng) >> 11) * 0x1.0p-53) + size * m->ms_per_byte;
+    case M_SSD:
+        return m->latency + size * m->ms_per_byte;
+    default:
+        return 0;
+    }
+}
+
+// Log-linear histogram: 2^HIST_SUB_BITS buckets per power of two, so any
+// percentile is within about 1% whatever the number of samples
+#define HIST_SUB_BITS 6
+#define HIST_MIN_EXP  (-20)
+#define HIST_ROWS     64
+
+typedef struct {
+    uint64_t count[HIST_ROWS << HIST_SUB_BITS];
+    uint64_t total;
+} latency_hist;
+
+static void hist_add(latency_hist *h, double v) {
+    size_t idx = 0;
+    int e;
+    double f = frexp(v, &e);  // v = f * 2^e, 0.5 <= f < 1
+    if (v > 0 && e > HIST_MIN_EXP) {
+        int row = e - HIST_MIN_EXP;
+        if (row >= HIST_ROWS) {
+            row = HIST_ROWS - 1;
+            f = 0.9999;
+        }
+        idx = (size_t)row << HIST_SUB_BITS | (size_t)((2 * f - 1) * (1 << HIST_SUB_BITS));
+    }
+    h->count[idx]++;
+    h->total++;
+}
+
+// Value below which a fraction p of the samples fall (bucket midpoint)
+static double hist_percentile(const latency_hist *h, double p) {
+    uint64_t want = (uint64_t)ceil(p * h->total), seen = 0;
+    if (want == 0) want = 1;
+    for (size_t i = 0; i < (size_t)HIST_ROWS << HIST_SUB_BITS; i++) {
+        seen += h->count[i];
+        if (seen >= want) {
+            if (i == 0) return 0;
+            double f = 0.5 * (1 + ((i & ((1 << HIST_SUB_BITS) - 1)) + 0.5) / (1 << HIST_SUB_BITS));
+            return ldexp(f, (int)(i >> HIST_SUB_BITS) + HIST_MIN_EXP);
+        }
+    }
+    return 0;
+}
+
+/* -------------------------------------------
+   Scheduler
+   ------------------------------------------- */
+
+typedef struct {
+    double arrival;
+    uint32_t cyl;
+    uint32_t size;
+    uint32_t next;  // next request in the same FIFO
+} request;
+
+typedef struct {
+    // pending requests: a node pool with a free list
+    request *pool;
+    uint32_t pool_size, free_list;
+    uint64_t pending;
+    // FCFS: one arrival-order FIFO; everything else: a FIFO per cylinder
+    uint32_t fifo_first, fifo_last;
+    uint32_t *cyl_first, *cyl_last;
+    cyl_set set;
+} queue;
+
+typedef struct {
+    uint64_t served;
+    uint64_t movement;  // cylinders travelled
+    uint64_t bytes;
+    double finish;      // time when the last request completed
+    double response;    // sum of (completion - arrival)
+    double max_response;
+    latency_hist hist;
+} sched_stats;
+
+static void enqueue(queue *q, enum policy pol, double arrival, uint32_t cyl, uint32_t size) {
+    if (q->free_list == NONE) {
+        uint32_t old = q->pool_size;
+        uint32_t grow = old ? old * 2 : 1024;
+        request *p = realloc(q->pool, (size_t)grow * sizeof(request));
+        if (!p || grow <= old) {
+            fprintf(stderr, "Too many pending requests\n");
+            exit(EXIT_FAILURE);
+        }
+        for (uint32_t i = old; i < grow; i++) p[i].next = i + 1 < grow ? i + 1 : NONE;
+        q->pool = p;
+        q->pool_size = grow;
+        q->free_list = old;
+    }
+    uint32_t id = q->free_list;
+    q->free_list = q->pool[id].next;
+    q->pool[id] = (request){ arrival, cyl, size, NONE };
+    q->pending++;
+
+    uint32_t *first = pol == P_FCFS ? &q->fifo_first : &q->cyl_first[cyl];
+    uint32_t *last = pol == P_FCFS ? &q->fifo_last : &q->cyl_last[cyl];
+    if (*first == NONE) {
+        *first = id;
+        if (pol != P_FCFS) cyl_set_add(&q->set, cyl);
+    } else {
+        q->pool[*last].next = id;
+    }
+    *last = id;
+}
+
+// Remove and return the oldest request (FCFS) or the oldest one at cyl
+static request dequeue(queue *q, enum policy pol, uint32_t cyl) {
+    uint32_t *first = pol == P_FCFS ? &q->fifo_first : &q->cyl_first[cyl];
+    uint32_t id = *first;
+    *first = q->pool[id].next;
+    if (*first == NONE && pol != P_FCFS) cyl_set_remove(&q->set, cyl);
+    request r = q->pool[id];
+    q->pool[id].next = q->free_list;
+    q->free_list = id;
+    q->pending--;
+    return r;
+}
+
+// Nearest pending cylinder at or beyond head in direction dir (+1/-1), or -1
+static int64_t look_ahead(const queue *q, uint32_t head, int dir) {
+    return dir > 0 ? cyl_set_next(&q->set, head) : cyl_set_prev(&q->set, head);
+}
+
+typedef struct {
+    uint32_t max_cyl;
+    uint32_t head;
+    int dir;             // initial sweep direction
+    double service;      // fixed cost per request (model time units)
+    int count_return;    // -j
+    uint64_t seed;       // rotational delays
+} sched_config;
+
+static void run_policy(enum policy pol, const sched_config *cfg, const disk_model *model, req_source *src,
+                       sched_stats *st) {
+    queue q = { .free_list = NONE, .fifo_first = NONE, .fifo_last = NONE };
+    if (pol != P_FCFS) {
+        q.cyl_first = malloc(((size_t)cfg->max_cyl + 1) * sizeof(uint32_t));
+        q.cyl_last = malloc(((size_t)cfg->max_cyl + 1) * sizeof(uint32_t));
+        if (!q.cyl_first || !q.cyl_last || cyl_set_init(&q.set, (uint64_t)cfg->max_cyl + 1) == -1) {
+            fprintf(stderr, "Out of memory for %u cylinders\n", cfg->max_cyl + 1);
+            exit(EXIT_FAILURE);
+        }
+        memset(q.cyl_first, 0xff, ((size_t)cfg->max_cyl + 1) * sizeof(uint32_t));
+    }
+
+    // now is the next dispatch time: when the earliest channel frees up
+    double channel_free[MAX_CHANNELS] = { 0 };
+    double now = 0;
+    uint32_t head = cfg->head;
+    int dir = cfg->dir;
+    uint64_t rng = cfg->seed * 0xD1B54A32D192ED03ULL + 1;
+    for (;;) {
+        int ch = 0;
+        for (int i = 1; i < model->channels; i++) {
+            if (channel_free[i] < channel_free[ch]) ch = i;
+        }
+        if (channel_free[ch] > now) now = channel_free[ch];
+
+        // Admit everything that has arrived; an idle disk waits for the next one
+        if (q.pending == 0) {
+            if (!source_peek(src)) break;
+            if (src->arrival > now) now = src->arrival;
+        }
+        while (source_peek(src) && src->arrival <= now) {
+            enqueue(&q, pol, src->arrival, src->cyl, src->size);
+            src->have = 0;
+        }
+
+        // Pick the next cylinder; travel to an edge or a return jump is
+        // charged to the clock, and to the movement unless it is a jump
+        uint64_t edge_travel = 0, jump = 0;
+        int64_t target;
+        switch (pol) {
+        case P_FCFS:
+            target = q.pool[q.fifo_first].cyl;
+            break;
+        case P_SSTF: {
+            int64_t below = cyl_set_prev(&q.set, head);
+            int64_t above = cyl_set_next(&q.set, head);
+            if (below < 0) target = above;
+            else if (above < 0) target = below;
+            else if (head - below != above - head) target = head - below < above - head ? below : above;
+            else target = dir > 0 ? above : below;  // tie: keep going the same way
+            break;
+        }
+        case P_SCAN:
+        case P_LOOK:
+            target = look_ahead(&q, head, dir);
+            if (target < 0) {
+                if (pol == P_SCAN) {
+                    uint32_t edge = dir > 0 ? cfg->max_cyl : 0;
+                    edge_travel = dir > 0 ? edge - head : head - edge;
+                    head = edge;
+                }
+                dir = -dir;
+                target = look_ahead(&q, head, dir);
+            }
+            break;
+        case P_CSCAN:
+        case P_CLOOK:
+        default:
+            target = look_ahead(&q, head, dir);
+            if (target < 0) {
+                uint32_t from = dir > 0 ? cfg->max_cyl : 0;
+                uint32_t to = dir > 0 ? 0 : cfg->max_cyl;
+                if (pol == P_CSCAN) {
+                    edge_travel = dir > 0 ? from - head : head - from;
+                    head = from;
+                } else {
+                    from = head;
+                }
+                target = look_ahead(&q, to, dir);
+                // C-SCAN returns to the far edge; C-LOOK straight to the farthest request
+                jump = pol == P_CSCAN ? cfg->max_cyl : (uint64_t)llabs((int64_t)from - target);
+                head = pol == P_CSCAN ? to : (uint32_t)target;
+            }
+            break;
+        }
+
+        uint64_t seek = (uint64_t)llabs((int64_t)head - target);
+        if (target != head) dir = target > head ? 1 : -1;
+        if (pol == P_CSCAN || pol == P_CLOOK) dir = cfg->dir;  // circular sweeps never turn
+        st->movement += edge_travel + seek + (cfg->count_return ? jump : 0);
+        head = (uint32_t)target;
+
+        request r = dequeue(&q, pol, head);
+        double done = now + seek_time(model, edge_travel) + seek_time(model, jump) + seek_time(model, seek) +
+                      access_time(model, r.size, &rng) + cfg->service;
+        channel_free[ch] = done;
+        if (model->channels == 1) now = done;
+
+        double response = done - r.arrival;
+        st->response += response;
+        if (response > st->max_response) st->max_response = response;
+        hist_add(&st->hist, response);
+        st->bytes += r.size;
+        st->served++;
+        if (done > st->finish) st->finish = done;
+    }
+
+    free(q.pool);
+    if (pol != P_FCFS) {
+        free(q.cyl_first);
+        free(q.cyl_last);
+        cyl_set_free(&q.set);
+    }
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: ./disk_sched [-n requests] [-C max_cylinder] [-a mean_gap] [-s service]\n"
+                    "                    [-t trace_file] [-p policy,...] [-d up|down] [-j] [-S seed]\n"
+                    "                    [-M units|hdd|ssd] [-k t2t,full] [-R rpm] [-X MB/s] [-L ms]\n"
+                    "                    [-Q channels] [-b bytes] [initial_head]\n"
+                    "Policies: fcfs, sstf, scan, look, cscan, clook (default: all)\n");
+    exit(EXIT_FAILURE);
+}
+
+static int parse_policies(const char *list, int *enabled) {
+    static const char *keys[P_COUNT] = { "fcfs", "sstf", "scan", "look", "cscan", "clook" };
+    char *copy = strdup(list), *save = NULL;
+    for (char *tok = strtok_r(copy, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        int found = 0;
+        for (int p = 0; p < P_COUNT; p++) {
+            if (strcmp(tok, keys[p]) == 0) enabled[p] = found = 1;
+        }
+        if (!found) {
+            free(copy);
+            return -1;
+        }
+    }
+    free(copy);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    sched_config cfg = { DEFAULT_MAX_CYL, DEFAULT_HEAD, -1, 0, 0, 0 };
+    disk_model model = { .kind = M_UNITS, .t2t = 0.8, .full = 15, .channels = 1 };
+    double rpm = 7200, mb_per_s = 0, ssd_latency = 0.08;
+    int channels = 8;
+    uint64_t requests = DEFAULT_REQUESTS;
+    uint32_t size = DEFAULT_SIZE;
+    double mean_gap = 0;
+    const char *trace = NULL;
+    int enabled[P_COUNT] = { 0 }, any = 0;
+
+    int argi = 1;
+    for (; argi < argc && argv[argi][0] == '-'; argi++) {
+        const char *opt = argv[argi];
+        if (strcmp(opt, "-j") == 0) {
+            cfg.count_return = 1;
+            continue;
+        }
+        if (argi + 1 >= argc) usage();
+        const char *val = argv[++argi];
+        if (strcmp(opt, "-n") == 0) requests = strtoull(val, NULL, 10);
+        else if (strcmp(opt, "-C") == 0) cfg.max_cyl = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(opt, "-a") == 0) mean_gap = atof(val);
+        else if (strcmp(opt, "-s") == 0) cfg.service = atof(val);
+        else if (strcmp(opt, "-t") == 0) trace = val;
+        else if (strcmp(opt, "-S") == 0) cfg.seed = strtoull(val, NULL, 10);
+        else if (strcmp(opt, "-d") == 0 && strcmp(val, "up") == 0) cfg.dir = 1;
+        else if (strcmp(opt, "-d") == 0 && strcmp(val, "down") == 0) cfg.dir = -1;
+        else if (strcmp(opt, "-p") == 0 && parse_policies(val, enabled) == 0) any = 1;
+        else if (strcmp(opt, "-M") == 0 && strcmp(val, "units") == 0) model.kind = M_UNITS;
+        else if (strcmp(opt, "-M") == 0 && strcmp(val, "hdd") == 0) model.kind = M_HDD;
+        else if (strcmp(opt, "-M") == 0 && strcmp(val, "ssd") == 0) model.kind = M_SSD;
+        else if (strcmp(opt, "-k") == 0 && sscanf(val, "%lf,%lf", &model.t2t, &model.full) == 2) continue;
+        else if (strcmp(opt, "-R") == 0) rpm = atof(val);
+        else if (strcmp(opt, "-X") == 0) mb_per_s = atof(val);
+        else if (strcmp(opt, "-L") == 0) ssd_latency = atof(val);
+        else if (strcmp(opt, "-Q") == 0) channels = atoi(val);
+        else if (strcmp(opt, "-b") == 0) size = (uint32_t)strtoul(val, NULL, 10);
+        else usage();
+    }
+    if (argi < argc) cfg.head = (uint32_t)strtoul(argv[argi++], NULL, 10);
+    if (argi != argc || cfg.max_cyl >= MAX_CYLINDERS || cfg.head > cfg.max_cyl || mean_gap < 0 || rpm <= 0 ||
+        mb_per_s < 0 || channels < 1 || channels > MAX_CHANNELS || model.full < model.t2t)
+        usage();
+
+    // Fill in the derived model parameters; the transfer rate defaults to
+    // what a 7200 rpm disk or one SATA-class flash channel sustains
+    model.span = cfg.max_cyl > 1 ? cfg.max_cyl : 1;
+    model.knee = 0.3 * model.span;
+    model.knee_g = 2 * model.knee / (model.span + model.knee);  // same slope on both sides of the knee
+    model.rev_ms = 60000.0 / rpm;
+    model.ms_per_byte = 1000.0 / ((mb_per_s > 0 ? mb_per_s : model.kind == M_SSD ? 500 : 150) * 1e6);
+    model.latency = ssd_latency;
+    if (model.kind == M_SSD) model.channels = channels;
+    int timed = model.kind != M_UNITS;
+    if (!any) {
+        for (int p = 0; p < P_COUNT; p++) enabled[p] = 1;
+    }
+
+    FILE *tf = NULL;
+    if (trace && !(tf = fopen(trace, "r"))) {
+        perror("Error opening trace file");
+        return 1;
+    }
+
+    if (timed) printf("Response times in ms\n");
+    printf("%-9s | %20s | %11s | %10s | %10s | %10s | %10s | %10s", "Algorithm", "Total Head Movement",
+           "Requests", "Mean", "p50", "p99", "p99.9", "Max");
+    if (timed) printf(" | %10s | %8s", "IOPS", "MB/s");
+    printf(" | %7s\n", "Run (s)");
+
+    sched_stats *st = malloc(sizeof(*st));
+    if (!st) {
+        perror("malloc");
+        return 1;
+    }
+    for (int p = 0; p < P_COUNT; p++) {
+        if (!enabled[p]) continue;
+        // Every policy replays the same stream from the start
+        req_source src = { .trace = tf, .remaining = requests,
+                           .rng = cfg.seed * 0x9E3779B97F4A7C15ULL + 0x2545F4914F6CDD1DULL, .mean_gap = mean_gap,
+                           .max_cyl = cfg.max_cyl, .default_size = size };
+        if (tf) rewind(tf);
+        memset(st, 0, sizeof(*st));
+
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        run_policy(p, &cfg, &model, &src, st);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        printf("%-9s | %20llu | %11llu | %10.2f | %10.2f | %10.2f | %10.2f | %10.2f", policy_names[p],
+               (unsigned long long)st->movement, (unsigned long long)st->served,
+               st->served ? st->response / st->served : 0.0, fmin(hist_percentile(&st->hist, 0.50), st->max_response),
+               fmin(hist_percentile(&st->hist, 0.99), st->max_response),
+               fmin(hist_percentile(&st->hist, 0.999), st->max_response), st->max_response);
+        if (timed) {
+            double secs = st->finish / 1000;
+            printf(" | %10.0f | %8.1f", secs > 0 ? st->served / secs : 0.0, secs > 0 ? st->bytes / secs / 1e6 : 0.0);
+        }
+        printf(" | %7.2f\n", (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+    }
+    free(st);
+    if (tf) fclose(tf);
+    return 0;
+}
@@ -0,0 +1,340 @@
+/*
+ * Divisor counts for a whole range with a segmented sieve.
+ *
+ * os_hw_2.py counts divisors by trial division up to sqrt(n) for every
+ * number (O(n sqrt n) overall), and its 8 "threads" share one interpreter
+ * lock, so they cannot run at the same time. Here the divisor count
+ * d(n) = (e1 + 1)(e2 + 1)... is built by sieving instead of dividing:
+ *   - every prime p <= sqrt(hi) walks its multiples in the segment, doubling
+ *     d and multiplying a running product of the prime powers found so far;
+ *     every higher power p^k walks its own (much rarer) multiples and turns
+ *     the factor k into k + 1,
+ *   - whatever is left (product != n) is a single prime above sqrt(hi),
+ *     which contributes one more factor of 2,
+ * so each number costs about sum(1/p) ~ log log n cheap updates.
+ * The range is cut into segments that stay in cache (12 bytes per number)
+ * and handed out by the work-stealing runtime in parallel_for.h; a worker
+ * carries its next-multiple offsets across the consecutive segments of one
+ * range instead of dividing again.
+ *
+ * Usage: ./divisors [-t threads] [-s segment_numbers] [-c grain] [-x sieve|trial]
+ *                   [-P steal|static] [-T] [lo] hi
+ *   -c  segments (or numbers with -x trial) a worker runs between splits
+ *   -x  trial: os_hw_2.py's trial division, whose cost grows with n
+ *   -P  static: os_hw_2.py's equal chunks instead of work stealing
+ *   -T  repeat the run with 1, 2, 4, ... threads to show the scaling
+ * With no range it searches 1..10000 like os_hw_2.py. Also prints the sum of
+ * d(n) over the range as a checksum.
+ * Build: gcc -O2 -pthread divisors.c -o divisors
+ */
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "parallel_for.h"
+
+#define DEFAULT_LOW       1
+#define DEFAULT_HIGH      10000
+#define DEFAULT_SEGMENT   (1 << 15)  // 32K numbers * 12 bytes = 384KB, stays in L2
+#define DEFAULT_JOB_SEGS  8          // default grain of the sieve
+#define MAX_HIGH          (1ULL << 40)
+
+// One sieving step: the multiples of q = p^k
+typedef struct {
+    uint64_t q;
+    uint32_t p;
+    uint32_t k;
+} sieve_step;
+
+typedef struct {
+    uint64_t number;    // smallest number with the most divisors
+    uint32_t divisors;
+    uint64_t sum;       // sum of d(n), a checksum
+} range_result;
+
+typedef struct {
+    uint64_t lo, hi;
+    uint64_t segment;   // numbers per segment
+    const sieve_step *steps;
+    size_t nsteps;
+    uint32_t **d;       // per-worker scratch: divisor counts,
+    uint64_t **prod;    // product of the prime powers found so far,
+    uint64_t **offset;  // next multiple of every step, relative to the segment
+} sieve_ctx;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t isqrt(uint64_t n) {
+    uint64_t r = (uint64_t)sqrtl((long double)n);
+    while (r * r > n) r--;
+    while ((r + 1) * (r + 1) <= n) r++;
+    return r;
+}
+
+// All prime powers p^k <= hi with p <= sqrt(hi), grouped by p in increasing k
+static sieve_step *build_steps(uint64_t hi, size_t *count) {
+    uint64_t limit = isqrt(hi);
+    char *composite = calloc(limit + 1, 1);
+    size_t cap = 1024, n = 0;
+    sieve_step *steps = malloc(cap * sizeof(*steps));
+    if (!composite || !steps) return NULL;
+
+    for (uint64_t p = 2; p <= limit; p++) {
+        if (composite[p]) continue;
+        for (uint64_t m = p * p; m <= limit; m += p) composite[m] = 1;
+        uint64_t q = p;
+        for (uint32_t k = 1;; k++) {
+            if (n == cap) {
+                cap *= 2;
+                steps = realloc(steps, cap * sizeof(*steps));
+                if (!steps) return NULL;
+            }
+            steps[n++] = (sieve_step){ q, (uint32_t)p, k };
+            if (q > hi / p) break;
+            q *= p;
+        }
+    }
+    free(composite);
+    *count = n;
+    return steps;
+}
+
+static void keep_best(range_result *best, uint64_t number, uint32_t divisors) {
+    if (divisors > best->divisors || (divisors == best->divisors && number < best->number)) {
+        best->number = number;
+        best->divisors = divisors;
+    }
+}
+
+// pf_body: sieve segments [first, last) of the range, in order
+static void sieve_segments(uint64_t first, uint64_t last, int worker, void *partial, void *arg) {
+    sieve_ctx *ctx = arg;
+    range_result *best = partial;
+    uint32_t *d = ctx->d[worker];
+    uint64_t *prod = ctx->prod[worker];
+    uint64_t *offset = ctx->offset[worker];
+    uint64_t base = ctx->lo + first * ctx->segment;
+    uint64_t end = ctx->lo + last * ctx->segment;
+    if (end > ctx->hi + 1) end = ctx->hi + 1;
+
+    // Only once per call: first multiple of q at or after base
+    for (size_t s = 0; s < ctx->nsteps; s++) {
+        uint64_t q = ctx->steps[s].q;
+        offset[s] = (q - base % q) % q;
+    }
+
+    for (uint64_t seg = base; seg < end; seg += ctx->segment) {
+        uint64_t len = end - seg < ctx->segment ? end - seg : ctx->segment;
+        for (uint64_t i = 0; i < len; i++) {
+            d[i] = 1;
+            prod[i] = 1;
+        }
+        for (size_t s = 0; s < ctx->nsteps; s++) {
+            const sieve_step *st = &ctx->steps[s];
+            uint64_t i = offset[s];
+            if (st->k == 1) {
+                for (; i < len; i += st->q) {
+                    d[i] <<= 1;
+                    prod[i] *= st->p;
+                }
+            } else {
+                // These already carry a factor k for p; make it k + 1
+                for (; i < len; i += st->q) {
+                    d[i] = d[i] / st->k * (st->k + 1);
+                    prod[i] *= st->p;
+                }
+            }
+            offset[s] = i - len;
+        }
+        for (uint64_t i = 0; i < len; i++) {
+            uint32_t dn = d[i] << (prod[i] != seg + i);  // one prime factor above sqrt(hi) left
+            best->sum += dn;
+            if (dn >= best->divisors) keep_best(best, seg + i, dn);
+        }
+    }
+}
+
+// os_hw_2.py's count_divisors(): the cost grows like sqrt(n), which makes
+// it a good irregular workload for comparing schedules (-x trial)
+static uint32_t trial_divisors(uint64_t n) {
+    uint32_t count = 0;
+    for (uint64_t i = 1; i * i <= n; i++) {
+        if (n % i == 0) count += i * i == n ? 1 : 2;
+    }
+    return count;
+}
+
+// pf_body: numbers lo + [first, last) by trial division
+static void trial_numbers(uint64_t first, uint64_t last, int worker, void *partial, void *arg) {
+    (void)worker;
+    const sieve_ctx *ctx = arg;
+    range_result *best = partial;
+    for (uint64_t n = ctx->lo + first; n < ctx->lo + last; n++) {
+        uint32_t dn = trial_divisors(n);
+        best->sum += dn;
+        if (dn >= best->divisors) keep_best(best, n, dn);
+    }
+}
+
+// pf_combine for range_result
+static void combine_results(void *into, const void *from, void *arg) {
+    (void)arg;
+    range_result *r = into;
+    const range_result *f = from;
+    if (f->divisors) keep_best(r, f->number, f->divisors);
+    r->sum += f->sum;
+}
+
+typedef struct {
+    pf_body body;
+    void *arg;
+    uint64_t begin, end;
+    int worker;
+    range_result result;
+} static_arg;
+
+static void *static_worker(void *p) {
+    static_arg *a = p;
+    a->body(a->begin, a->end, a->worker, &a->result, a->arg);
+    return NULL;
+}
+
+// os_hw_2.py's schedule for comparison (-P static): equal chunks, the
+// remainder to the last thread
+static range_result static_reduce(int threads, uint64_t begin, uint64_t end, pf_body body, void *arg) {
+    pthread_t *tid = malloc(threads * sizeof(pthread_t));
+    static_arg *args = calloc(threads, sizeof(static_arg));
+    if (!tid || !args) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    uint64_t chunk = (end - begin) / threads;
+    for (int t = 0; t < threads; t++) {
+        args[t] = (static_arg){ body, arg, begin + t * chunk, t == threads - 1 ? end : begin + (t + 1) * chunk, t,
+                                { 0, 0, 0 } };
+        if (pthread_create(&tid[t], NULL, static_worker, &args[t]) != 0) {
+            perror("pthread_create");
+            exit(EXIT_FAILURE);
+        }
+    }
+    range_result total = { 0, 0, 0 };
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tid[t], NULL);
+        combine_results(&total, &args[t].result, NULL);
+    }
+    free(tid);
+    free(args);
+    return total;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: ./divisors [-t threads] [-s segment_numbers] [-c grain] [-x sieve|trial]\n"
+                    "                  [-P steal|static] [-T] [lo] hi\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t segment = DEFAULT_SEGMENT, grain = 0;
+    uint64_t lo = DEFAULT_LOW, hi = DEFAULT_HIGH;
+    int sweep = 0, trial = 0, static_split = 0;
+
+    int argi = 1;
+    for (; argi < argc && argv[argi][0] == '-'; argi++) {
+        if (strcmp(argv[argi], "-T") == 0) {
+            sweep = 1;
+            continue;
+        }
+        if (argi + 1 >= argc) usage();
+        const char *opt = argv[argi], *val = argv[++argi];
+        if (strcmp(opt, "-t") == 0) threads = atoi(val);
+        else if (strcmp(opt, "-s") == 0) segment = strtoull(val, NULL, 10);
+        else if (strcmp(opt, "-c") == 0) grain = strtoull(val, NULL, 10);
+        else if (strcmp(opt, "-x") == 0 && strcmp(val, "sieve") == 0) trial = 0;
+        else if (strcmp(opt, "-x") == 0 && strcmp(val, "trial") == 0) trial = 1;
+        else if (strcmp(opt, "-P") == 0 && strcmp(val, "steal") == 0) static_split = 0;
+        else if (strcmp(opt, "-P") == 0 && strcmp(val, "static") == 0) static_split = 1;
+        else usage();
+    }
+    if (argc - argi == 1) {
+        hi = strtoull(argv[argi], NULL, 10);
+    } else if (argc - argi == 2) {
+        lo = strtoull(argv[argi], NULL, 10);
+        hi = strtoull(argv[argi + 1], NULL, 10);
+    } else if (argc != argi) {
+        usage();
+    }
+    if (threads < 1 || segment < 1 || lo < 1 || lo > hi || hi > MAX_HIGH) usage();
+
+    double start = now_seconds();
+    sieve_ctx ctx = { .lo = lo, .hi = hi, .segment = segment };
+    sieve_step *steps = build_steps(hi, &ctx.nsteps);
+    ctx.steps = steps;
+    ctx.d = calloc(threads, sizeof(*ctx.d));
+    ctx.prod = calloc(threads, sizeof(*ctx.prod));
+    ctx.offset = calloc(threads, sizeof(*ctx.offset));
+    if (!steps || !ctx.d || !ctx.prod || !ctx.offset) {
+        perror("malloc");
+        return 1;
+    }
+    for (int t = 0; t < threads && !trial; t++) {
+        ctx.d[t] = malloc(segment * sizeof(uint32_t));
+        ctx.prod[t] = malloc(segment * sizeof(uint64_t));
+        ctx.offset[t] = malloc(ctx.nsteps * sizeof(uint64_t));
+        if (!ctx.d[t] || !ctx.prod[t] || !ctx.offset[t]) {
+            perror("malloc");
+            return 1;
+        }
+    }
+    // The sieve works in segments, trial division in single numbers
+    pf_body body = trial ? trial_numbers : sieve_segments;
+    uint64_t items = trial ? hi - lo + 1 : (hi - lo + segment) / segment;
+    if (grain == 0 && !trial) grain = DEFAULT_JOB_SEGS;
+    printf("Range %llu..%llu, %s, %s schedule (%.3f s setup)\n", (unsigned long long)lo, (unsigned long long)hi,
+           trial ? "trial division" : "segmented sieve", static_split ? "static" : "work-stealing",
+           now_seconds() - start);
+
+    // -T: 1, 2, 4, ... up to the requested thread count
+    for (int t = sweep ? 1 : threads;; t = t * 2 < threads ? t * 2 : threads) {
+        start = now_seconds();
+        range_result r = { 0, 0, 0 };
+        if (static_split) {
+            r = static_reduce(t, 0, items, body, &ctx);
+        } else {
+            pf_pool *pool = pf_create(t);
+            if (!pool || pf_reduce(pool, 0, items, grain, body, &ctx, sizeof(r), NULL, combine_results, &r) != 0) {
+                fprintf(stderr, "Could not start %d threads\n", t);
+                return 1;
+            }
+            pf_destroy(pool);
+        }
+        double elapsed = now_seconds() - start;
+
+        printf("%d thread(s):\n", t);
+        printf("Number with most divisors: %llu\n", (unsigned long long)r.number);
+        printf("Divisor count: %u\n", r.divisors);
+        printf("Sum of divisor counts: %llu\n", (unsigned long long)r.sum);
+        printf("Time taken: %.6f seconds (%.1f M numbers/s)\n", elapsed, (hi - lo + 1) / elapsed / 1e6);
+        printf("----------------------------------------\n");
+        if (t == threads) break;
+    }
+
+    for (int t = 0; t < threads; t++) {
+        free(ctx.d[t]);
+        free(ctx.prod[t]);
+        free(ctx.offset[t]);
+    }
+    free(ctx.d);
+    free(ctx.prod);
+    free(ctx.offset);
+    free(steps);
+    return 0;
+}
@@ -1,208 +1,2984 @@
 // The Link of the raw data log file: https://github.com/logpai/loghub/blob/master/Windows/Windows_2k.log_structured.csv
 // Feature of the dataset that I will be working with:
 // Is a .csv
-// Has 2000 rows of data 
+// Has 2000 rows of data
 // 6 columns per rows
 // column categories: LineId, Date, Time, Level, Component, Contentt
+//
+// Usage: ./group_project [-q] [-c] [-w query] [-i] [-s search] [-T] [-R] [-m access]
+//                        [-a [-u err] [-e err] [-d delta] [-k top] [-t threads]] [file.csv ...]
+//        ./group_project -D socket [file.csv ...]
+//        ./group_project -C socket "STATS" | "COUNT query" | "ROWS query"
+//   -q  only print the summary, not every row
+//   -c  only count the rows that match -w or -s
+//   -w  keep only matching rows, e.g. "level = Error and content ~ 'failed'"
+//   -i  also write an inverted index of Content to file.csv.idx
+//   -s  look terms up in file.csv.idx instead of parsing, e.g. "failed and (cbs or csi*)"
+//   -T  group Content into templates (Drain) and count rows per template
+//   -R  the files are raw log lines, not CSV: mine templates from whole lines
+//   -m  how to read the files, comma-separated, and report time and page faults per file:
+//       seq       madvise(MADV_SEQUENTIAL)
+//       willneed  madvise(MADV_WILLNEED)
+//       populate  MAP_POPULATE: fault the whole file in up front
+//       prefetch  a thread faults pages in up to 16MB ahead of the parser (not with -a)
+//       huge      read() into a staging buffer of 2MB pages (hugetlbfs, else transparent)
+//       cold      evict the file from the page cache first
+//       none      plain mmap(), the default
+//   -D  stay running: keep the files parsed, follow them and answer -C requests on socket
+//   -C  ask a -D daemon; ROWS results arrive through shared memory
+//   -a  approximate per-column summaries in fixed memory, parsed on -t threads (default: all CPUs):
+//       -u  distinct-count relative error (default 0.01)
+//       -e  heavy-hitter count error as a fraction of the rows (default 0.0005)
+//       -d  probability of exceeding -e (default 0.01)
+//       -k  most frequent values shown per column (default 10)
+// Build: gcc -O2 -mavx2 -pthread group_project.c -o group_project -lm
 
+#define _GNU_SOURCE  // memfd_create, accept4, open_memstream
+#include <errno.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/inotify.h>
 #include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include "parallel_for.h"
 
-#define MAX_LINE_LENGTH 1024
-#define MAX_UNIQUE      100  // Adjusted to account for a higher number of unique items (dates, times, components, levels)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define DEFAULT_LOG_FILE "/home/kali/Downloads/Windows_2k.log_structured.csv"
+#define ARENA_CHUNK      (1 << 20)  // Content text is bump-allocated in 1MB chunks
+#define MAX_FIELDS       8          // the structured CSVs also carry EventId and EventTemplate
+
+// Parsed records are kept as a structure of arrays instead of an array of
+// fixed-size structs. The old LogEntry was 584 bytes per row and cut
+// Content at 499 characters; here a row costs 34 bytes of columns plus the
+// exact length of its Content, which lives in an arena that is freed in one
+// go when the file is done.
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* -------------------------------------------
+   Bump-pointer arena
+   ------------------------------------------- */
+
+typedef struct arena_chunk {
+    struct arena_chunk *next;
+    size_t used, size;
+    char data[];
+} arena_chunk;
+
+typedef struct {
+    arena_chunk *head;
+    size_t reserved;    // bytes malloc()ed for chunks
+} log_arena;
+
+// Hand out len bytes; there is no per-allocation free
+static void *arena_alloc(log_arena *a, size_t len) {
+    arena_chunk *c = a->head;
+    if (c && c->size - c->used >= len) {
+        void *p = c->data + c->used;
+        c->used += len;
+        return p;
+    }
+    // A big string gets a chunk of its own behind the current one, so the
+    // space left in the current chunk is not thrown away
+    size_t size = len > ARENA_CHUNK / 4 ? len : ARENA_CHUNK;
+    arena_chunk *n = malloc(sizeof(*n) + size);
+    if (!n) return NULL;
+    n->size = size;
+    n->used = len;
+    a->reserved += sizeof(*n) + size;
+    if (c && size == len) {
+        n->next = c->next;
+        c->next = n;
+    } else {
+        n->next = c;
+        a->head = n;
+    }
+    return n->data;
+}
+
+static void arena_free(log_arena *a) {
+    arena_chunk *c = a->head;
+    while (c) {
+        arena_chunk *next = c->next;
+        free(c);
+        c = next;
+    }
+    a->head = NULL;
+    a->reserved = 0;
+}
+
+/* -------------------------------------------
+   String dictionary (Level, Component)
+   ------------------------------------------- */
+
+// Every distinct string gets a small integer id; rows store the id
+typedef struct {
+    uint32_t *slots;      // id + 1, 0 = empty (open addressing)
+    size_t slot_mask;
+    const char **names;   // id -> NUL-terminated name (in the arena)
+    uint32_t *lengths;
+    uint32_t count, cap;
+} string_dict;
+
+static uint64_t hash_bytes(const char *s, size_t len) {
+    uint64_t h = 1469598103934665603ULL;  // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static int dict_grow(string_dict *d) {
+    size_t slots = d->slot_mask ? (d->slot_mask + 1) * 2 : 64;
+    uint32_t *s = calloc(slots, sizeof(uint32_t));
+    if (!s) return -1;
+    for (uint32_t id = 0; id < d->count; id++) {
+        size_t i = hash_bytes(d->names[id], d->lengths[id]) & (slots - 1);
+        while (s[i]) i = (i + 1) & (slots - 1);
+        s[i] = id + 1;
+    }
+    free(d->slots);
+    d->slots = s;
+    d->slot_mask = slots - 1;
+    return 0;
+}
+
+// Id of s[0..len), or -1 if it has not been seen
+static int64_t dict_find(const string_dict *d, const char *s, size_t len) {
+    if (!d->slots) return -1;
+    for (size_t i = hash_bytes(s, len) & d->slot_mask; d->slots[i]; i = (i + 1) & d->slot_mask) {
+        uint32_t id = d->slots[i] - 1;
+        if (d->lengths[id] == len && memcmp(d->names[id], s, len) == 0) return id;
+    }
+    return -1;
+}
+
+// Id of s[0..len), adding it if new; -1 when out of memory
+static int64_t dict_intern(string_dict *d, log_arena *a, const char *s, size_t len) {
+    if ((d->count + 1) * 2 > d->slot_mask + 1 && dict_grow(d) == -1) return -1;
+    size_t i = hash_bytes(s, len) & d->slot_mask;
+    for (; d->slots[i]; i = (i + 1) & d->slot_mask) {
+        uint32_t id = d->slots[i] - 1;
+        if (d->lengths[id] == len && memcmp(d->names[id], s, len) == 0) return id;
+    }
+    if (d->count == d->cap) {
+        uint32_t cap = d->cap ? d->cap * 2 : 16;
+        const char **names = realloc(d->names, cap * sizeof(*names));
+        if (!names) return -1;
+        d->names = names;
+        uint32_t *lengths = realloc(d->lengths, cap * sizeof(*lengths));
+        if (!lengths) return -1;
+        d->lengths = lengths;
+        d->cap = cap;
+    }
+    char *copy = arena_alloc(a, len + 1);
+    if (!copy) return -1;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    d->names[d->count] = copy;
+    d->lengths[d->count] = (uint32_t)len;
+    d->slots[i] = ++d->count;
+    return d->count - 1;
+}
+
+static void dict_free(string_dict *d) {
+    free(d->slots);
+    free(d->names);
+    free(d->lengths);
+    memset(d, 0, sizeof(*d));
+}
+
+/* -------------------------------------------
+   Template mining
+   ------------------------------------------- */
+
+// -T groups Content into templates online, the way Drain (He et al.,
+// ICWS 2017) does; loghub made the EventTemplate column of the structured
+// CSVs with it. Tokens are split on blanks and interned, and a token with a
+// digit in it is masked as <*> up front. A message then walks a fixed-depth
+// prefix tree: first its token count, then its first TEMPLATE_DEPTH - 2
+// tokens (a node with too many children sends new tokens to its <*>
+// child). The leaf holds the templates of that shape; the message joins the
+// one sharing the most tokens if that is at least TEMPLATE_SIM of them,
+// turning the positions that differ into <*>, or starts a new template.
+// -R does the same for raw, unstructured logs: every line is a message.
+
+#define TEMPLATE_DEPTH    4     // root, token count, then 2 token levels
+#define TEMPLATE_SIM      0.5   // share of equal tokens needed to join a template
+#define TEMPLATE_CHILDREN 100   // widest a tree node gets before new tokens go to <*>
+#define WILDCARD          0     // token id of <*>
+
+typedef struct {
+    uint32_t *tokens;    // in the miner's arena; WILDCARD where values vary
+    uint32_t len;
+    uint64_t count;
+} log_template;
+
+typedef struct {
+    uint32_t parent, key, child;   // key: token id, or the token count below the root; child 0 = empty
+} tree_edge;
+
+typedef struct {
+    uint32_t children;
+    uint32_t *templates;           // leaves: ids of the templates with this prefix
+    uint32_t ntemplates, cap;
+} tree_node;
+
+typedef struct {
+    string_dict tokens;
+    log_arena arena;
+    tree_node *nodes;              // node 0 is the root
+    uint32_t nnodes, nodes_cap;
+    tree_edge *edges;
+    size_t edge_mask, nedges;
+    log_template *templates;
+    uint32_t ntemplates, templates_cap;
+    uint32_t *scratch;             // token ids of the current message
+    size_t scratch_cap;
+} template_miner;
+
+static void miner_free(template_miner *m) {
+    for (uint32_t i = 0; i < m->nnodes; i++) free(m->nodes[i].templates);
+    free(m->nodes);
+    free(m->edges);
+    free(m->templates);
+    free(m->scratch);
+    dict_free(&m->tokens);
+    arena_free(&m->arena);
+    memset(m, 0, sizeof(*m));
+}
+
+static int miner_init(template_miner *m) {
+    memset(m, 0, sizeof(*m));
+    m->nodes = calloc(64, sizeof(*m->nodes));
+    m->edges = calloc(1024, sizeof(*m->edges));
+    if (!m->nodes || !m->edges || dict_intern(&m->tokens, &m->arena, "<*>", 3) != WILDCARD) {
+        miner_free(m);
+        return -1;
+    }
+    m->nodes_cap = 64;
+    m->nnodes = 1;
+    m->edge_mask = 1023;
+    return 0;
+}
+
+static size_t edge_slot(const template_miner *m, uint32_t parent, uint32_t key) {
+    uint64_t k = ((uint64_t)parent << 32 | key) * 0x9E3779B97F4A7C15ULL;
+    return (k >> 32) & m->edge_mask;
+}
+
+// Child of parent under key, or 0 if there is none
+static uint32_t tree_child(const template_miner *m, uint32_t parent, uint32_t key) {
+    for (size_t i = edge_slot(m, parent, key); m->edges[i].child; i = (i + 1) & m->edge_mask) {
+        if (m->edges[i].parent == parent && m->edges[i].key == key) return m->edges[i].child;
+    }
+    return 0;
+}
+
+// Same, adding the child if it is missing; 0 when out of memory
+static uint32_t tree_add_child(template_miner *m, uint32_t parent, uint32_t key) {
+    uint32_t child = tree_child(m, parent, key);
+    if (child) return child;
+    if ((m->nedges + 1) * 2 > m->edge_mask + 1) {
+        size_t slots = (m->edge_mask + 1) * 2;
+        tree_edge *e = calloc(slots, sizeof(*e));
+        if (!e) return 0;
+        tree_edge *old = m->edges;
+        size_t old_slots = m->edge_mask + 1;
+        m->edges = e;
+        m->edge_mask = slots - 1;
+        for (size_t i = 0; i < old_slots; i++) {
+            if (!old[i].child) continue;
+            size_t j = edge_slot(m, old[i].parent, old[i].key);
+            while (e[j].child) j = (j + 1) & m->edge_mask;
+            e[j] = old[i];
+        }
+        free(old);
+    }
+    if (m->nnodes == m->nodes_cap) {
+        tree_node *n = realloc(m->nodes, m->nodes_cap * 2 * sizeof(*n));
+        if (!n) return 0;
+        memset(n + m->nodes_cap, 0, m->nodes_cap * sizeof(*n));
+        m->nodes = n;
+        m->nodes_cap *= 2;
+    }
+    child = m->nnodes++;
+    size_t i = edge_slot(m, parent, key);
+    while (m->edges[i].child) i = (i + 1) & m->edge_mask;
+    m->edges[i] = (tree_edge){ parent, key, child };
+    m->nedges++;
+    m->nodes[parent].children++;
+    return child;
+}
+
+static int has_digit(const char *s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] >= '0' && s[i] <= '9') return 1;
+    }
+    return 0;
+}
+
+// Template id of the message s[0..len), creating or widening a template as
+// needed; -1 when out of memory
+static int64_t miner_add(template_miner *m, const char *s, size_t len) {
+    // Tokenize and mask
+    size_t n = 0, i = 0;
+    while (i < len) {
+        while (i < len && (s[i] == ' ' || s[i] == '\t')) i++;
+        if (i == len) break;
+        size_t start = i;
+        while (i < len && s[i] != ' ' && s[i] != '\t') i++;
+        if (n == m->scratch_cap) {
+            size_t cap = m->scratch_cap ? m->scratch_cap * 2 : 64;
+            uint32_t *p = realloc(m->scratch, cap * sizeof(*p));
+            if (!p) return -1;
+            m->scratch = p;
+            m->scratch_cap = cap;
+        }
+        int64_t id = has_digit(s + start, i - start) ? WILDCARD : dict_intern(&m->tokens, &m->arena, s + start, i - start);
+        if (id < 0) return -1;
+        m->scratch[n++] = (uint32_t)id;
+    }
+    const uint32_t *tok = m->scratch;
+
+    // Walk the prefix tree: token count, then the first tokens
+    uint32_t node = tree_add_child(m, 0, (uint32_t)n);
+    for (size_t d = 0; node && d < TEMPLATE_DEPTH - 2 && d < n; d++) {
+        uint32_t next = tree_child(m, node, tok[d]);
+        if (!next) {
+            int full = m->nodes[node].children + 1 >= TEMPLATE_CHILDREN;
+            next = tree_add_child(m, node, full ? WILDCARD : tok[d]);
+        }
+        node = next;
+    }
+    if (!node) return -1;
+
+    // The most similar template in the leaf; ties go to the more general one
+    tree_node *leaf = &m->nodes[node];
+    int64_t best = -1;
+    size_t best_same = 0, best_wild = 0;
+    for (uint32_t k = 0; k < leaf->ntemplates; k++) {
+        const log_template *t = &m->templates[leaf->templates[k]];
+        size_t same = 0, wild = 0;
+        for (size_t j = 0; j < n; j++) {
+            if (t->tokens[j] == WILDCARD) wild++;
+            else same += t->tokens[j] == tok[j];
+        }
+        if (best < 0 || same > best_same || (same == best_same && wild > best_wild)) {
+            best = leaf->templates[k];
+            best_same = same;
+            best_wild = wild;
+        }
+    }
+    if (best >= 0 && best_same >= TEMPLATE_SIM * n) {
+        log_template *t = &m->templates[best];
+        for (size_t j = 0; j < n; j++) {
+            if (t->tokens[j] != tok[j]) t->tokens[j] = WILDCARD;
+        }
+        t->count++;
+        return best;
+    }
+
+    // A new template
+    if (m->ntemplates == m->templates_cap) {
+        uint32_t cap = m->templates_cap ? m->templates_cap * 2 : 64;
+        log_template *t = realloc(m->templates, cap * sizeof(*t));
+        if (!t) return -1;
+        m->templates = t;
+        m->templates_cap = cap;
+    }
+    if (leaf->ntemplates == leaf->cap) {
+        uint32_t cap = leaf->cap ? leaf->cap * 2 : 4;
+        uint32_t *t = realloc(leaf->templates, cap * sizeof(*t));
+        if (!t) return -1;
+        leaf->templates = t;
+        leaf->cap = cap;
+    }
+    // The arena packs strings, so align the token array by hand
+    char *raw = arena_alloc(&m->arena, n * sizeof(uint32_t) + sizeof(uint32_t) - 1);
+    if (!raw) return -1;
+    uint32_t *copy = (uint32_t *)(((uintptr_t)raw + sizeof(uint32_t) - 1) & ~(uintptr_t)(sizeof(uint32_t) - 1));
+    memcpy(copy, tok, n * sizeof(*copy));
+    uint32_t id = m->ntemplates++;
+    m->templates[id] = (log_template){ copy, (uint32_t)n, 1 };
+    leaf->templates[leaf->ntemplates++] = id;
+    return id;
+}
+
+static void print_template(const template_miner *m, uint32_t id) {
+    const log_template *t = &m->templates[id];
+    for (uint32_t j = 0; j < t->len; j++) printf("%s%s", j ? " " : "", m->tokens.names[t->tokens[j]]);
+}
+
+static void print_template_counts(const template_miner *m) {
+    printf("\n=== Template Counts (%u templates) ===\n", m->ntemplates);
+    for (uint32_t id = 0; id < m->ntemplates; id++) {
+        printf("  E%-5u %8llu  ", id + 1, (unsigned long long)m->templates[id].count);
+        print_template(m, id);
+        printf("\n");
+    }
+}
+
+/* -------------------------------------------
+   Column store
+   ------------------------------------------- */
+
+typedef struct {
+    size_t rows, cap;
+    uint64_t *line_id;
+    uint32_t *date;          // YYYYMMDD
+    uint32_t *time;          // seconds since midnight
+    uint16_t *level;         // id in levels
+    uint32_t *component;     // id in components
+    const char **content;    // NUL-terminated, in the arena
+    uint32_t *content_len;
+    uint32_t *template_id;   // only with a miner
+    string_dict levels, components;
+    log_arena arena;
+    template_miner *miner;   // -T: mine Content while parsing
+} log_table;
+
+static int table_grow(log_table *t) {
+    size_t cap = t->cap ? t->cap * 2 : 4096;
+#define GROW(col)                                             \
+    do {                                                      \
+        void *p = realloc(t->col, cap * sizeof(*t->col));     \
+        if (!p) return -1;                                    \
+        t->col = p;                                           \
+    } while (0)
+    GROW(line_id);
+    GROW(date);
+    GROW(time);
+    GROW(level);
+    GROW(component);
+    GROW(content);
+    GROW(content_len);
+    if (t->miner) GROW(template_id);
+#undef GROW
+    t->cap = cap;
+    return 0;
+}
+
+// Everything that belongs to one file goes away here at once
+static void table_free(log_table *t) {
+    free(t->line_id);
+    free(t->date);
+    free(t->time);
+    free(t->level);
+    free(t->component);
+    free(t->content);
+    free(t->content_len);
+    free(t->template_id);
+    dict_free(&t->levels);
+    dict_free(&t->components);
+    arena_free(&t->arena);
+    memset(t, 0, sizeof(*t));
+}
+
+static size_t table_bytes(const log_table *t) {
+    size_t per_row = sizeof(*t->line_id) + sizeof(*t->date) + sizeof(*t->time) + sizeof(*t->level) +
+                     sizeof(*t->component) + sizeof(*t->content) + sizeof(*t->content_len) +
+                     (t->miner ? sizeof(*t->template_id) : 0);
+    return t->cap * per_row + t->arena.reserved;
+}
+
+/* -------------------------------------------
+   Parsing
+   ------------------------------------------- */
+
+typedef struct {
+    const char *s;
+    size_t len;
+    int quoted;  // may contain "" escapes
+} csv_field;
+
+// Split one CSV line (no newline) into fields; quoted fields may contain
+// commas. If it stops after max fields and more follow, *rest points at the
+// next one, otherwise it is set to NULL
+static int split_csv(const char *p, const char *end, csv_field *fields, int max, const char **rest) {
+    int n = 0;
+    if (rest) *rest = NULL;
+    for (;;) {
+        if (n == max) {
+            if (rest) *rest = p;
+            return n;  // leave the remaining columns alone
+        }
+        csv_field *f = &fields[n++];
+        f->quoted = p < end && *p == '"';
+        if (f->quoted) {
+            const char *q = ++p;
+            while (q < end && !(*q == '"' && (q + 1 == end || q[1] != '"'))) q += *q == '"' ? 2 : 1;
+            f->s = p;
+            f->len = (q < end ? q : end) - p;
+            p = q < end ? q + 1 : end;
+        } else {
+            const char *c = memchr(p, ',', end - p);
+            f->s = p;
+            f->len = (c ? c : end) - p;
+            p = c ? c : end;
+        }
+        if (p == end) return n;
+        p++;  // skip the comma
+    }
+}
+
+static int parse_digits(const char *s, size_t len, uint32_t *out) {
+    uint32_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') return 0;
+        v = v * 10 + (s[i] - '0');
+    }
+    *out = v;
+    return len > 0;
+}
+
+// "YYYY-MM-DD" -> YYYYMMDD
+static int parse_date(const csv_field *f, uint32_t *out) {
+    uint32_t y, m, d;
+    if (f->len != 10 || f->s[4] != '-' || f->s[7] != '-') return 0;
+    if (!parse_digits(f->s, 4, &y) || !parse_digits(f->s + 5, 2, &m) || !parse_digits(f->s + 8, 2, &d)) return 0;
+    *out = y * 10000 + m * 100 + d;
+    return 1;
+}
+
+// "HH:MM:SS" -> seconds since midnight
+static int parse_time(const csv_field *f, uint32_t *out) {
+    uint32_t h, m, s;
+    if (f->len != 8 || f->s[2] != ':' || f->s[5] != ':') return 0;
+    if (!parse_digits(f->s, 2, &h) || !parse_digits(f->s + 3, 2, &m) || !parse_digits(f->s + 6, 2, &s)) return 0;
+    *out = h * 3600 + m * 60 + s;
+    return 1;
+}
+
+/* -------------------------------------------
+   Query predicates
+   ------------------------------------------- */
+
+// -w takes a small boolean language over the columns, e.g.
+//   level = Error and component in (CBS, CSI) and content ~ 'failed'
+//   time >= 02:00:00 and time < 03:00:00 and not level = Info
+// Fields are lineid, date, time, level, component and content (any case).
+// lineid/date/time compare with = != < <= > >=, level/component take
+// = != in (...) and ~ (contains), content takes ~. "and" binds tighter
+// than "or"; values with spaces or punctuation go in '...' or "...".
+//
+// The text is compiled once into a plan: an array of nodes whose and/or
+// children are ordered cheapest first. For every file the Level/Component
+// literals are interned into the table's dictionaries, so = and in become
+// a bit test on the row's dictionary id. During the parse pass the plan
+// first runs without Content using three-valued logic; Content is only
+// split out, searched and copied for rows the other columns cannot decide.
+
+enum { F_LINEID, F_DATE, F_TIME, F_LEVEL, F_COMPONENT, F_CONTENT };  // = CSV column
+enum { Q_AND, Q_OR, Q_NOT, Q_CMP, Q_IN, Q_CONTAINS };
+enum { OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE };
+enum { Q_FALSE, Q_TRUE, Q_UNKNOWN };
+
+typedef struct {
+    int kind, field, op;
+    int left, right;        // children of and/or/not
+    int cost;               // rough price of evaluating this subtree
+    uint64_t value;         // Q_CMP
+    char **strings;         // Q_IN literals, or the Q_CONTAINS needle
+    int nstrings;
+    uint64_t *ids;          // Q_IN: bitmap of the literals' dictionary ids
+    size_t id_words;
+    char *needle_quoted;    // Q_CONTAINS: needle with " doubled, for quoted fields
+    size_t needle_len, needle_quoted_len;
+} q_node;
+
+typedef struct {
+    q_node *nodes;
+    int n, cap, root;
+} query;
 
-// Structure to hold the log entries
 typedef struct {
-    int  LineId;
-    char Date[11];      // YYYY-MM-DD
-    char Time[9];       // HH:MM:SS
-    char Level[10];     // Log level like INFO, ERROR
-    char Component[50]; // Component name
-    char Content[500];  // Content of the log
-} LogEntry;
+    const char *p;      // next unread character
+    query *q;
+} q_parser;
+
+static const char *field_names[] = { "lineid", "date", "time", "level", "component", "content" };
+
+static char query_error[128];  // why the last query_compile() failed
+
+static int q_error(const q_parser *ps, const char *msg) {
+    snprintf(query_error, sizeof(query_error), "Bad query near \"%.20s\": %s", ps->p, msg);
+    return -1;
+}
+
+static int q_add(query *q, q_node node) {
+    if (q->n == q->cap) {
+        int cap = q->cap ? q->cap * 2 : 16;
+        q_node *nodes = realloc(q->nodes, cap * sizeof(*nodes));
+        if (!nodes) return -1;
+        q->nodes = nodes;
+        q->cap = cap;
+    }
+    q->nodes[q->n] = node;
+    return q->n++;
+}
+
+// and/or nodes put their cheaper side first so it can short-circuit the other
+static int q_add_binary(q_parser *ps, int kind, int left, int right) {
+    query *q = ps->q;
+    if (q->nodes[left].cost > q->nodes[right].cost) {
+        int tmp = left;
+        left = right;
+        right = tmp;
+    }
+    q_node node = { .kind = kind, .left = left, .right = right };
+    node.cost = q->nodes[left].cost + q->nodes[right].cost;
+    int i = q_add(q, node);
+    return i < 0 ? q_error(ps, "out of memory") : i;
+}
+
+static void q_skip_space(q_parser *ps) {
+    while (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\n') ps->p++;
+}
+
+static int is_word_char(char c) {
+    return c && !strchr(" \t\n()',=!<>~\"", c);
+}
+
+// Consume kw if it is the next whole word
+static int q_keyword(q_parser *ps, const char *kw) {
+    q_skip_space(ps);
+    size_t n = strlen(kw);
+    if (strncasecmp(ps->p, kw, n) != 0 || is_word_char(ps->p[n])) return 0;
+    ps->p += n;
+    return 1;
+}
+
+static int q_punct(q_parser *ps, char c) {
+    q_skip_space(ps);
+    if (*ps->p != c) return 0;
+    ps->p++;
+    return 1;
+}
+
+// A bare word or a '...'/"..." string, malloc()ed; NULL if there is none
+static char *q_value(q_parser *ps) {
+    q_skip_space(ps);
+    const char *s = ps->p, *e;
+    if (*s == '\'' || *s == '"') {
+        e = strchr(s + 1, *s);
+        if (!e) return NULL;
+        ps->p = e + 1;
+        s++;
+    } else {
+        for (e = s; is_word_char(*e); e++) {}
+        if (e == s) return NULL;
+        ps->p = e;
+    }
+    return strndup(s, e - s);
+}
+
+static int q_field(q_parser *ps) {
+    for (int f = 0; f <= F_CONTENT; f++) {
+        if (q_keyword(ps, field_names[f])) return f;
+    }
+    return -1;
+}
+
+static int q_op(q_parser *ps) {
+    q_skip_space(ps);
+    static const struct { const char *text; int op; } ops[] = {
+        { "!=", OP_NE }, { "<=", OP_LE }, { ">=", OP_GE }, { "=", OP_EQ }, { "<", OP_LT }, { ">", OP_GT },
+    };
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        size_t n = strlen(ops[i].text);
+        if (strncmp(ps->p, ops[i].text, n) == 0) {
+            ps->p += n;
+            return ops[i].op;
+        }
+    }
+    return -1;
+}
+
+static int q_append_string(q_node *node, char *s) {
+    char **strings = realloc(node->strings, (node->nstrings + 1) * sizeof(*strings));
+    if (!strings) {
+        free(s);
+        return -1;
+    }
+    node->strings = strings;
+    node->strings[node->nstrings++] = s;
+    return 0;
+}
+
+static void q_node_free(q_node *node) {
+    for (int i = 0; i < node->nstrings; i++) free(node->strings[i]);
+    free(node->strings);
+    free(node->ids);
+    free(node->needle_quoted);
+}
+
+// field ~ value | field in (v, ...) | field op value
+static int q_condition(q_parser *ps) {
+    int field = q_field(ps);
+    if (field < 0) return q_error(ps, "expected lineid, date, time, level, component or content");
+    int is_string = field >= F_LEVEL, is_list = 0;
+    q_node node = { .field = field };
+
+    if (q_punct(ps, '~')) {
+        node.kind = Q_CONTAINS;
+        node.cost = field == F_CONTENT ? 16 : 4;  // Content has to be split out first
+    } else if (q_keyword(ps, "in")) {
+        node.kind = Q_IN;
+        node.op = OP_EQ;
+        node.cost = 2;
+        is_list = 1;
+    } else if ((node.op = q_op(ps)) >= 0) {
+        node.kind = is_string ? Q_IN : Q_CMP;
+        node.cost = is_string ? 2 : 1;
+    } else {
+        return q_error(ps, "expected an operator");
+    }
+    if ((node.kind == Q_IN && field == F_CONTENT) || (node.kind != Q_CMP && !is_string))
+        return q_error(ps, "operator does not apply to this field");
+    if (node.kind == Q_IN && node.op != OP_EQ && node.op != OP_NE)
+        return q_error(ps, "level and component only support = != in ~");
+
+    if (is_list) {
+        if (!q_punct(ps, '(')) return q_error(ps, "expected ( after in");
+        do {
+            char *v = q_value(ps);
+            if (!v || q_append_string(&node, v) == -1) {
+                q_node_free(&node);
+                return q_error(ps, "expected a value");
+            }
+        } while (q_punct(ps, ','));
+        if (!q_punct(ps, ')')) {
+            q_node_free(&node);
+            return q_error(ps, "expected ) after the list");
+        }
+    } else {
+        const char *at = ps->p;
+        char *v = q_value(ps);
+        if (!v) return q_error(ps, "expected a value");
+        if (node.kind == Q_CMP) {
+            csv_field f = { v, strlen(v), 0 };
+            uint32_t x;
+            int ok = field == F_LINEID ? parse_digits(f.s, f.len, &x)
+                   : field == F_DATE   ? parse_date(&f, &x)
+                                       : parse_time(&f, &x);
+            free(v);
+            if (!ok) {
+                ps->p = at;
+                return q_error(ps, field == F_DATE ? "dates are YYYY-MM-DD"
+                                   : field == F_TIME ? "times are HH:MM:SS" : "expected a number");
+            }
+            node.value = x;
+        } else if (q_append_string(&node, v) == -1) {
+            return q_error(ps, "out of memory");
+        }
+    }
+
+    if (node.kind == Q_CONTAINS) {
+        // Quoted CSV fields keep their "" escapes; search those with a
+        // needle escaped the same way instead of unescaping every row
+        const char *s = node.strings[0];
+        node.needle_len = strlen(s);
+        node.needle_quoted = malloc(node.needle_len * 2 + 1);
+        if (!node.needle_quoted) {
+            q_node_free(&node);
+            return q_error(ps, "out of memory");
+        }
+        size_t n = 0;
+        for (; *s; s++) {
+            node.needle_quoted[n++] = *s;
+            if (*s == '"') node.needle_quoted[n++] = '"';
+        }
+        node.needle_quoted[n] = '\0';
+        node.needle_quoted_len = n;
+    }
+    int i = q_add(ps->q, node);
+    if (i < 0) {
+        q_node_free(&node);
+        return q_error(ps, "out of memory");
+    }
+    return i;
+}
+
+static int q_or(q_parser *ps);
+
+static int q_unary(q_parser *ps) {
+    if (q_keyword(ps, "not")) {
+        int child = q_unary(ps);
+        if (child < 0) return -1;
+        q_node node = { .kind = Q_NOT, .left = child, .cost = ps->q->nodes[child].cost };
+        int i = q_add(ps->q, node);
+        return i < 0 ? q_error(ps, "out of memory") : i;
+    }
+    if (q_punct(ps, '(')) {
+        int inner = q_or(ps);
+        if (inner < 0) return -1;
+        if (!q_punct(ps, ')')) return q_error(ps, "expected )");
+        return inner;
+    }
+    return q_condition(ps);
+}
+
+static int q_and(q_parser *ps) {
+    int left = q_unary(ps);
+    while (left >= 0 && q_keyword(ps, "and")) {
+        int right = q_unary(ps);
+        left = right < 0 ? -1 : q_add_binary(ps, Q_AND, left, right);
+    }
+    return left;
+}
+
+static int q_or(q_parser *ps) {
+    int left = q_and(ps);
+    while (left >= 0 && q_keyword(ps, "or")) {
+        int right = q_and(ps);
+        left = right < 0 ? -1 : q_add_binary(ps, Q_OR, left, right);
+    }
+    return left;
+}
+
+static void query_free(query *q) {
+    for (int i = 0; i < q->n; i++) q_node_free(&q->nodes[i]);
+    free(q->nodes);
+    memset(q, 0, sizeof(*q));
+}
+
+// Parse text into q; returns -1 with the reason in query_error if it is not valid
+static int query_compile(query *q, const char *text) {
+    memset(q, 0, sizeof(*q));
+    q_parser ps = { text, q };
+    q->root = q_or(&ps);
+    q_skip_space(&ps);
+    if (q->root >= 0 && *ps.p) q->root = q_error(&ps, "unexpected text");
+    if (q->root < 0) {
+        query_free(q);
+        return -1;
+    }
+    return 0;
+}
+
+// Resolve the Level/Component literals against t's dictionaries. With intern
+// they are added so that rows seen later get the same ids; otherwise (a table
+// that is already loaded) a literal that is not in the dictionary matches no
+// row and leaves the dictionary alone. -1 when out of memory
+static int query_bind(query *q, log_table *t, int intern) {
+    for (int i = 0; i < q->n; i++) {
+        q_node *node = &q->nodes[i];
+        if (node->kind != Q_IN) continue;
+        string_dict *d = node->field == F_LEVEL ? &t->levels : &t->components;
+        free(node->ids);
+        node->ids = NULL;
+        node->id_words = 0;
+        for (int k = 0; k < node->nstrings; k++) {
+            size_t len = strlen(node->strings[k]);
+            int64_t id = intern ? dict_intern(d, &t->arena, node->strings[k], len) : dict_find(d, node->strings[k], len);
+            if (id < 0) {
+                if (intern) return -1;
+                continue;
+            }
+            size_t words = (size_t)id / 64 + 1;
+            if (words > node->id_words) {
+                uint64_t *ids = realloc(node->ids, words * sizeof(*ids));
+                if (!ids) return -1;
+                memset(ids + node->id_words, 0, (words - node->id_words) * sizeof(*ids));
+                node->ids = ids;
+                node->id_words = words;
+            }
+            node->ids[id / 64] |= 1ULL << (id % 64);
+        }
+    }
+    return 0;
+}
+
+// Does hay[0..n) contain needle[0..m)? Candidates are found by comparing the
+// first and last needle byte at 32 (AVX2) or 16 (SSE2) positions at once
+static int contains_bytes(const char *hay, size_t n, const char *needle, size_t m) {
+    if (m == 0) return 1;
+    if (n < m) return 0;
+    size_t last = n - m, i = 0;
+    char first = needle[0], tail = needle[m - 1];
+#if defined(__AVX2__)
+    __m256i vf = _mm256_set1_epi8(first);
+    __m256i vl = _mm256_set1_epi8(tail);
+    for (; i + 32 <= last + 1; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(hay + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(hay + i + m - 1));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, vf), _mm256_cmpeq_epi8(b, vl)));
+        for (; mask; mask &= mask - 1) {
+            if (memcmp(hay + i + __builtin_ctz(mask), needle, m) == 0) return 1;
+        }
+    }
+#elif defined(__SSE2__)
+    __m128i vf = _mm_set1_epi8(first);
+    __m128i vl = _mm_set1_epi8(tail);
+    for (; i + 16 <= last + 1; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(hay + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(hay + i + m - 1));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, vf), _mm_cmpeq_epi8(b, vl)));
+        for (; mask; mask &= mask - 1) {
+            if (memcmp(hay + i + __builtin_ctz(mask), needle, m) == 0) return 1;
+        }
+    }
+#endif
+    for (; i <= last; i++) {
+        if (hay[i] == first && hay[i + m - 1] == tail && memcmp(hay + i, needle, m) == 0) return 1;
+    }
+    return 0;
+}
+
+// What the plan sees of the line being parsed
+typedef struct {
+    uint32_t line_id, date, time;
+    int64_t level, component;   // -1: not in the dictionary
+    const csv_field *fields;
+    int have_content;           // fields[F_CONTENT] has been split out
+} row_view;
+
+static int q_eval(const query *q, int i, const row_view *r) {
+    const q_node *node = &q->nodes[i];
+    switch (node->kind) {
+    case Q_AND: {
+        int a = q_eval(q, node->left, r);
+        if (a == Q_FALSE) return Q_FALSE;
+        int b = q_eval(q, node->right, r);
+        if (b == Q_FALSE) return Q_FALSE;
+        return a == Q_TRUE && b == Q_TRUE ? Q_TRUE : Q_UNKNOWN;
+    }
+    case Q_OR: {
+        int a = q_eval(q, node->left, r);
+        if (a == Q_TRUE) return Q_TRUE;
+        int b = q_eval(q, node->right, r);
+        if (b == Q_TRUE) return Q_TRUE;
+        return a == Q_FALSE && b == Q_FALSE ? Q_FALSE : Q_UNKNOWN;
+    }
+    case Q_NOT: {
+        int a = q_eval(q, node->left, r);
+        return a == Q_UNKNOWN ? Q_UNKNOWN : a == Q_TRUE ? Q_FALSE : Q_TRUE;
+    }
+    case Q_CMP: {
+        uint64_t v = node->field == F_LINEID ? r->line_id : node->field == F_DATE ? r->date : r->time;
+        switch (node->op) {
+        case OP_EQ: return v == node->value;
+        case OP_NE: return v != node->value;
+        case OP_LT: return v < node->value;
+        case OP_LE: return v <= node->value;
+        case OP_GT: return v > node->value;
+        default:    return v >= node->value;
+        }
+    }
+    case Q_IN: {
+        int64_t id = node->field == F_LEVEL ? r->level : r->component;
+        int hit = id >= 0 && (uint64_t)id / 64 < node->id_words && (node->ids[id / 64] >> (id % 64) & 1);
+        return node->op == OP_NE ? !hit : hit;
+    }
+    default: {
+        if (node->field == F_CONTENT && !r->have_content) return Q_UNKNOWN;
+        const csv_field *f = &r->fields[node->field];
+        return f->quoted ? contains_bytes(f->s, f->len, node->needle_quoted, node->needle_quoted_len)
+                         : contains_bytes(f->s, f->len, node->strings[0], node->needle_len);
+    }
+    }
+}
+
+/* -------------------------------------------
+   Parse pass
+   ------------------------------------------- */
+
+// Parse one CSV line and, if it passes `where` (NULL: every row), append it
+// to t when `store` is set. Returns 1 for a matching row, 2 for one the
+// filter rejected, 0 for a malformed line, -1 when out of memory
+int parse_log_line(const char *line, const char *end, log_table *t, const query *where, int store) {
+    csv_field f[MAX_FIELDS];
+    const char *rest;
+    if (split_csv(line, end, f, F_CONTENT, &rest) < F_CONTENT || !rest) return 0;
+
+    row_view row = { .fields = f };
+    if (!parse_digits(f[0].s, f[0].len, &row.line_id) || !parse_date(&f[1], &row.date) ||
+        !parse_time(&f[2], &row.time))
+        return 0;
+
+    // Cheap columns first: a row the filter rejects here is never interned,
+    // and its Content is neither scanned for quotes nor copied
+    int verdict = Q_TRUE;
+    if (where) {
+        row.level = dict_find(&t->levels, f[3].s, f[3].len);
+        row.component = dict_find(&t->components, f[4].s, f[4].len);
+        verdict = q_eval(where, where->root, &row);
+        if (verdict == Q_FALSE) return 2;
+        if (verdict == Q_TRUE && !store) return 1;
+    }
+    split_csv(rest, end, f + F_CONTENT, MAX_FIELDS - F_CONTENT, NULL);
+    if (verdict == Q_UNKNOWN) {
+        row.have_content = 1;
+        if (q_eval(where, where->root, &row) == Q_FALSE) return 2;
+    }
+    if (!store) return 1;
+    if (t->rows == t->cap && table_grow(t) == -1) return -1;
+
+    int64_t level = dict_intern(&t->levels, &t->arena, f[3].s, f[3].len);
+    int64_t component = dict_intern(&t->components, &t->arena, f[4].s, f[4].len);
+    char *content = arena_alloc(&t->arena, f[5].len + 1);
+    if (level < 0 || component < 0 || !content) return -1;
+    if (level > UINT16_MAX) return 0;
+
+    // Copy Content whole, turning "" back into "
+    size_t n = 0;
+    for (size_t i = 0; i < f[5].len; i++) {
+        content[n++] = f[5].s[i];
+        if (f[5].quoted && f[5].s[i] == '"') i++;
+    }
+    content[n] = '\0';
+
+    size_t r = t->rows;
+    if (t->miner) {
+        int64_t id = miner_add(t->miner, content, n);
+        if (id < 0) return -1;
+        t->template_id[r] = (uint32_t)id;
+    }
+    t->rows++;
+    t->line_id[r] = row.line_id;
+    t->date[r] = row.date;
+    t->time[r] = row.time;
+    t->level[r] = (uint16_t)level;
+    t->component[r] = (uint32_t)component;
+    t->content[r] = content;
+    t->content_len[r] = (uint32_t)n;
+    return 1;
+}
+
+/* -------------------------------------------
+   Inverted index over Content
+   ------------------------------------------- */
+
+// -i writes <file>.idx next to each CSV; -s answers term queries from it
+// without parsing the CSV again. Content is split into terms (runs of
+// letters, digits and _, lowercased; longer than MAX_TERM is skipped) and
+// every term keeps the sorted LineIds of the rows that contain it.
+//
+// File layout, all little-endian and 8-byte aligned:
+//   index_header
+//   index_term[terms]   sorted by name, so lookups and prefixes are a binary search
+//   names               the term strings, back to back
+//   postings            per term: LineId deltas as LEB128 varints
+// Search mmap()s the file and only decodes the lists a query touches.
+
+#define INDEX_MAGIC "LOGIDX1"
+#define MAX_TERM    64
+
+typedef struct {
+    char magic[8];
+    uint64_t rows;        // rows that were indexed
+    uint64_t terms;
+    uint64_t term_table, names, postings, size;  // offsets / total file size
+} index_header;
+
+typedef struct {
+    uint64_t postings;    // offset into the postings area
+    uint32_t name, name_len;
+    uint32_t bytes;       // length of the encoded list
+    uint32_t count;       // LineIds in the list
+} index_term;
+
+typedef struct {
+    uint64_t *ids;
+    size_t n, cap;
+} id_list;
+
+typedef struct {
+    unsigned char *p;
+    size_t n, cap;
+} byte_buf;
+
+static int is_term_char(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static int list_push(id_list *l, uint64_t id) {
+    if (l->n == l->cap) {
+        size_t cap = l->cap ? l->cap * 2 : 4;
+        uint64_t *ids = realloc(l->ids, cap * sizeof(*ids));
+        if (!ids) return -1;
+        l->ids = ids;
+        l->cap = cap;
+    }
+    l->ids[l->n++] = id;
+    return 0;
+}
+
+static int buf_reserve(byte_buf *b, size_t more) {
+    if (b->n + more <= b->cap) return 0;
+    size_t cap = b->cap ? b->cap : 1 << 16;
+    while (cap < b->n + more) cap *= 2;
+    unsigned char *p = realloc(b->p, cap);
+    if (!p) return -1;
+    b->p = p;
+    b->cap = cap;
+    return 0;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static const string_dict *sort_terms_dict;  // qsort() has no context argument
+
+static int cmp_term_ids(const void *a, const void *b) {
+    const string_dict *d = sort_terms_dict;
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    size_t n = d->lengths[x] < d->lengths[y] ? d->lengths[x] : d->lengths[y];
+    int c = memcmp(d->names[x], d->names[y], n);
+    return c ? c : (d->lengths[x] > d->lengths[y]) - (d->lengths[x] < d->lengths[y]);
+}
+
+// Sort and deduplicate a list (LineIds are usually ascending already)
+static void list_normalize(id_list *l) {
+    size_t k = 1;
+    for (; k < l->n && l->ids[k - 1] < l->ids[k]; k++) {}
+    if (k >= l->n) return;
+    qsort(l->ids, l->n, sizeof(*l->ids), cmp_u64);
+    size_t out = 1;
+    for (size_t i = 1; i < l->n; i++) {
+        if (l->ids[i] != l->ids[out - 1]) l->ids[out++] = l->ids[i];
+    }
+    l->n = out;
+}
+
+// Index the rows of t into path; returns -1 (errno set) on failure
+static int index_write(const log_table *t, const char *path, uint64_t *terms_out, size_t *bytes_out) {
+    string_dict terms = { 0 };
+    log_arena arena = { 0 };
+    id_list *lists = NULL;
+    uint32_t *order = NULL;
+    index_term *table = NULL;
+    byte_buf postings = { 0 };
+    size_t lists_cap = 0;
+    char *tmp = NULL;
+    FILE *out = NULL;
+    int rc = -1;
+
+    // Build the term -> LineIds lists
+    char term[MAX_TERM];
+    for (size_t r = 0; r < t->rows; r++) {
+        const char *s = t->content[r];
+        size_t len = t->content_len[r], i = 0;
+        while (i < len) {
+            while (i < len && !is_term_char(s[i])) i++;
+            size_t start = i;
+            while (i < len && is_term_char(s[i])) i++;
+            size_t n = i - start;
+            if (n == 0 || n > MAX_TERM) continue;
+            for (size_t k = 0; k < n; k++) {
+                char c = s[start + k];
+                term[k] = c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+            }
+            int64_t id = dict_intern(&terms, &arena, term, n);
+            if (id < 0) goto done;
+            if ((size_t)id >= lists_cap) {
+                size_t cap = lists_cap ? lists_cap * 2 : 1024;
+                id_list *l = realloc(lists, cap * sizeof(*l));
+                if (!l) goto done;
+                memset(l + lists_cap, 0, (cap - lists_cap) * sizeof(*l));
+                lists = l;
+                lists_cap = cap;
+            }
+            id_list *l = &lists[id];
+            // A term repeated within a row only needs one posting
+            if ((l->n == 0 || l->ids[l->n - 1] != t->line_id[r]) && list_push(l, t->line_id[r]) == -1) goto done;
+        }
+    }
+
+    order = malloc((terms.count + 1) * sizeof(*order));
+    table = calloc(terms.count + 1, sizeof(*table));
+    if (!order || !table) goto done;
+    for (uint32_t i = 0; i < terms.count; i++) order[i] = i;
+    sort_terms_dict = &terms;
+    qsort(order, terms.count, sizeof(*order), cmp_term_ids);
+
+    // Encode the postings in term order
+    uint64_t names = 0;
+    for (uint32_t k = 0; k < terms.count; k++) {
+        uint32_t id = order[k];
+        id_list *l = &lists[id];
+        list_normalize(l);
+        if (buf_reserve(&postings, l->n * 10) == -1) goto done;
+        table[k] = (index_term){ postings.n, (uint32_t)names, terms.lengths[id], 0, (uint32_t)l->n };
+        uint64_t prev = 0;
+        for (size_t i = 0; i < l->n; i++) {
+            uint64_t d = l->ids[i] - prev;
+            prev = l->ids[i];
+            while (d >= 0x80) {
+                postings.p[postings.n++] = (unsigned char)(d | 0x80);
+                d >>= 7;
+            }
+            postings.p[postings.n++] = (unsigned char)d;
+        }
+        table[k].bytes = (uint32_t)(postings.n - table[k].postings);
+        names += terms.lengths[id];
+    }
+
+    index_header h = { INDEX_MAGIC, t->rows, terms.count, 0, 0, 0, 0 };
+    h.term_table = sizeof(h);
+    h.names = h.term_table + terms.count * sizeof(index_term);
+    h.postings = (h.names + names + 7) & ~7ULL;
+    h.size = h.postings + postings.n;
+
+    // Write next to the target and rename, so a reader never sees half a file
+    tmp = malloc(strlen(path) + 5);
+    if (!tmp) goto done;
+    sprintf(tmp, "%s.tmp", path);
+    out = fopen(tmp, "wb");
+    if (!out) goto done;
+    static const char pad[8];
+    int ok = fwrite(&h, sizeof(h), 1, out) == 1 &&
+             fwrite(table, sizeof(*table), terms.count, out) == terms.count;
+    for (uint32_t k = 0; ok && k < terms.count; k++) {
+        ok = fwrite(terms.names[order[k]], 1, terms.lengths[order[k]], out) == terms.lengths[order[k]];
+    }
+    ok = ok && fwrite(pad, 1, h.postings - h.names - names, out) == h.postings - h.names - names &&
+         fwrite(postings.p, 1, postings.n, out) == postings.n;
+    if (fclose(out) != 0) ok = 0;
+    out = NULL;
+    if (!ok || rename(tmp, path) == -1) {
+        unlink(tmp);
+        goto done;
+    }
+    *terms_out = terms.count;
+    *bytes_out = h.size;
+    rc = 0;
+
+done:
+    if (out) {
+        fclose(out);
+        unlink(tmp);
+    }
+    for (size_t i = 0; i < lists_cap; i++) free(lists[i].ids);
+    free(lists);
+    free(order);
+    free(table);
+    free(postings.p);
+    free(tmp);
+    dict_free(&terms);
+    arena_free(&arena);
+    return rc;
+}
+
+typedef struct {
+    char *base;
+    size_t size;
+    const index_header *h;
+    const index_term *terms;
+    const char *names;
+    const unsigned char *postings;
+} log_index;
+
+static int index_open(log_index *ix, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return -1;
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < (off_t)sizeof(index_header)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    ix->base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ix->base == MAP_FAILED) return -1;
+    ix->size = size;
+    ix->h = (const index_header *)ix->base;
+    const index_header *h = ix->h;
+
+    // Check the layout once so lookups can trust the offsets
+    int ok = memcmp(h->magic, INDEX_MAGIC, sizeof(h->magic)) == 0 && h->size == ix->size &&
+             h->term_table == sizeof(*h) && h->terms <= (h->size - h->term_table) / sizeof(index_term) &&
+             h->names == h->term_table + h->terms * sizeof(index_term) && h->names <= h->postings &&
+             h->postings <= h->size;
+    ix->terms = (const index_term *)(ix->base + h->term_table);
+    ix->names = ix->base + h->names;
+    ix->postings = (const unsigned char *)ix->base + h->postings;
+    for (uint64_t k = 0; ok && k < h->terms; k++) {
+        const index_term *t = &ix->terms[k];
+        ok = (uint64_t)t->name + t->name_len <= h->postings - h->names &&
+             t->postings + t->bytes <= h->size - h->postings && t->count <= t->bytes;
+    }
+    if (!ok) {
+        munmap(ix->base, ix->size);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+static void index_close(log_index *ix) {
+    munmap(ix->base, ix->size);
+}
+
+// Compare term k with s[0..len), looking at no more than the first len
+// bytes of the term when prefix is set
+static int index_cmp(const log_index *ix, uint64_t k, const char *s, size_t len, int prefix) {
+    const index_term *t = &ix->terms[k];
+    size_t n = t->name_len < len ? t->name_len : len;
+    int c = memcmp(ix->names + t->name, s, n);
+    if (c || (prefix && t->name_len >= len)) return c;
+    return (t->name_len > len) - (t->name_len < len);
+}
+
+// First term >= s[0..len)
+static uint64_t index_lower_bound(const log_index *ix, const char *s, size_t len) {
+    uint64_t lo = 0, hi = ix->h->terms;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (index_cmp(ix, mid, s, len, 0) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Append the LineIds of term k to out
+static int index_decode(const log_index *ix, uint64_t k, id_list *out) {
+    const index_term *t = &ix->terms[k];
+    const unsigned char *p = ix->postings + t->postings, *end = p + t->bytes;
+    uint64_t id = 0;
+    for (uint32_t i = 0; i < t->count; i++) {
+        uint64_t d = 0;
+        for (int shift = 0;; shift += 7) {
+            if (p == end || shift > 63) return -1;
+            d |= (uint64_t)(*p & 0x7f) << shift;
+            if (!(*p++ & 0x80)) break;
+        }
+        id += d;
+        if (list_push(out, id) == -1) return -1;
+    }
+    return 0;
+}
+
+// Intersect a and b into a (b is freed). Walks the shorter list and gallops
+// through the longer one, so "rare and common" costs about the rare list
+static void list_and(id_list *a, id_list *b) {
+    if (a->n > b->n) {
+        id_list tmp = *a;
+        *a = *b;
+        *b = tmp;
+    }
+    size_t out = 0, j = 0;
+    for (size_t i = 0; i < a->n && j < b->n; i++) {
+        uint64_t x = a->ids[i];
+        size_t lo = j, hi = j, step = 1;
+        while (hi < b->n && b->ids[hi] < x) {
+            lo = hi + 1;
+            hi += step;
+            step *= 2;
+        }
+        if (hi > b->n) hi = b->n;
+        while (lo < hi) {  // first b->ids[] >= x is in [lo, hi]
+            size_t mid = lo + (hi - lo) / 2;
+            if (b->ids[mid] < x) lo = mid + 1;
+            else hi = mid;
+        }
+        j = lo;
+        if (j < b->n && b->ids[j] == x) a->ids[out++] = x;
+    }
+    a->n = out;
+    free(b->ids);
+}
+
+// Union of a and b into a (b is freed); -1 when out of memory
+static int list_or(id_list *a, id_list *b) {
+    id_list u = { malloc((a->n + b->n + 1) * sizeof(uint64_t)), 0, a->n + b->n + 1 };
+    if (!u.ids) return -1;
+    size_t i = 0, j = 0;
+    while (i < a->n || j < b->n) {
+        uint64_t x = j == b->n || (i < a->n && a->ids[i] < b->ids[j]) ? a->ids[i] : b->ids[j];
+        if (i < a->n && a->ids[i] == x) i++;
+        if (j < b->n && b->ids[j] == x) j++;
+        u.ids[u.n++] = x;
+    }
+    free(a->ids);
+    free(b->ids);
+    *a = u;
+    return 0;
+}
+
+// Search syntax: terms, "and" (or just juxtaposition), "or", parentheses,
+// and term* for every term starting with term. A word such as c:\windows
+// is split like Content is and its terms are and-ed.
+typedef struct {
+    const char *p;
+    const log_index *ix;
+    int failed;
+} search_parser;
+
+static int search_keyword(search_parser *sp, const char *kw) {
+    while (*sp->p == ' ' || *sp->p == '\t') sp->p++;
+    size_t n = strlen(kw);
+    if (strncasecmp(sp->p, kw, n) != 0 || (sp->p[n] && !strchr(" \t()", sp->p[n]))) return 0;
+    sp->p += n;
+    return 1;
+}
+
+static void search_error(search_parser *sp, const char *msg) {
+    if (!sp->failed) fprintf(stderr, "Bad search near \"%.20s\": %s\n", sp->p, msg);
+    sp->failed = 1;
+}
+
+// Every LineId of term[0..len), or of every term it prefixes
+static void search_term(search_parser *sp, const char *term, size_t len, int prefix, id_list *out) {
+    const log_index *ix = sp->ix;
+    uint64_t k = index_lower_bound(ix, term, len);
+    int many = 0;
+    for (; k < ix->h->terms && index_cmp(ix, k, term, len, prefix) == 0; k++) {
+        if (index_decode(ix, k, out) == -1) {
+            search_error(sp, "corrupt posting list or out of memory");
+            return;
+        }
+        many++;
+        if (!prefix) break;
+    }
+    if (many > 1) list_normalize(out);
+}
+
+static void search_or(search_parser *sp, id_list *out);
+
+static void search_atom(search_parser *sp, id_list *out) {
+    while (*sp->p == ' ' || *sp->p == '\t') sp->p++;
+    if (*sp->p == '(') {
+        sp->p++;
+        search_or(sp, out);
+        while (*sp->p == ' ' || *sp->p == '\t') sp->p++;
+        if (*sp->p == ')') sp->p++;
+        else search_error(sp, "expected )");
+        return;
+    }
+    const char *s = sp->p, *e = s;
+    while (*e && !strchr(" \t()", *e)) e++;
+    if (e == s) {
+        search_error(sp, "expected a term");
+        return;
+    }
+    sp->p = e;
+    int prefix = e[-1] == '*', first = 1;
+    if (prefix) e--;
+
+    char term[MAX_TERM];
+    while (s < e) {
+        while (s < e && !is_term_char(*s)) s++;
+        size_t n = 0;
+        for (; s < e && is_term_char(*s); s++) {
+            if (n < MAX_TERM) term[n] = *s >= 'A' && *s <= 'Z' ? *s + ('a' - 'A') : *s;
+            n++;
+        }
+        if (n == 0) continue;
+        id_list l = { 0 };
+        if (n <= MAX_TERM) search_term(sp, term, n, prefix && s == e, &l);
+        if (first) *out = l;
+        else list_and(out, &l);
+        first = 0;
+    }
+    if (first) search_error(sp, "no searchable characters in term");
+}
+
+static void search_and(search_parser *sp, id_list *out) {
+    search_atom(sp, out);
+    while (!sp->failed) {
+        int explicit_and = search_keyword(sp, "and");
+        while (*sp->p == ' ' || *sp->p == '\t') sp->p++;
+        const char *save = sp->p;
+        if (!explicit_and && (!*sp->p || *sp->p == ')' || search_keyword(sp, "or"))) {
+            sp->p = save;
+            return;
+        }
+        id_list rhs = { 0 };
+        search_atom(sp, &rhs);
+        list_and(out, &rhs);
+    }
+}
+
+static void search_or(search_parser *sp, id_list *out) {
+    search_and(sp, out);
+    while (!sp->failed && search_keyword(sp, "or")) {
+        id_list rhs = { 0 };
+        search_and(sp, &rhs);
+        if (list_or(out, &rhs) == -1) {
+            free(rhs.ids);
+            search_error(sp, "out of memory");
+        }
+    }
+}
+
+/* -------------------------------------------
+   Counting
+   ------------------------------------------- */
+
+// Count of every distinct 32-bit key, reported in first-seen order
+typedef struct {
+    uint32_t *slots;   // index + 1 into keys/counts, 0 = empty
+    size_t slot_mask;
+    uint32_t *keys;
+    size_t *counts;
+    size_t n, cap;
+} key_counter;
+
+static void incr_counter(key_counter *c, uint32_t key) {
+    if ((c->n + 1) * 2 > c->slot_mask + 1) {
+        size_t slots = c->slot_mask ? (c->slot_mask + 1) * 2 : 64;
+        uint32_t *s = calloc(slots, sizeof(uint32_t));
+        if (!s) return;
+        for (size_t k = 0; k < c->n; k++) {
+            size_t i = (c->keys[k] * 2654435761u) & (slots - 1);
+            while (s[i]) i = (i + 1) & (slots - 1);
+            s[i] = (uint32_t)k + 1;
+        }
+        free(c->slots);
+        c->slots = s;
+        c->slot_mask = slots - 1;
+    }
+    size_t i = (key * 2654435761u) & c->slot_mask;
+    for (; c->slots[i]; i = (i + 1) & c->slot_mask) {
+        if (c->keys[c->slots[i] - 1] == key) {
+            c->counts[c->slots[i] - 1]++;
+            return;
+        }
+    }
+    if (c->n == c->cap) {
+        size_t cap = c->cap ? c->cap * 2 : 64;
+        uint32_t *keys = realloc(c->keys, cap * sizeof(*keys));
+        size_t *counts = keys ? realloc(c->counts, cap * sizeof(*counts)) : NULL;
+        if (keys) c->keys = keys;
+        if (!counts) return;
+        c->counts = counts;
+        c->cap = cap;
+    }
+    c->keys[c->n] = key;
+    c->counts[c->n] = 1;
+    c->slots[i] = (uint32_t)++c->n;
+}
+
+static void counter_free(key_counter *c) {
+    free(c->slots);
+    free(c->keys);
+    free(c->counts);
+}
+
+/* -------------------------------------------
+   Approximate counting
+   ------------------------------------------- */
+
+// -a swaps the exact per-value counts for fixed-size sketches, one per
+// column: a HyperLogLog for the number of distinct values and a Count-Min
+// sketch with a top-k heap for the most frequent ones. Their size depends
+// only on the error bounds, never on the rows or the distinct values, and
+// two sketches with the same bounds merge exactly (registers by max,
+// counters by sum). So the file is parsed in APPROX_PIECE pieces on a
+// work-stealing pool, the per-worker sketches are merged, and the per-file
+// results are merged again into a total over all files.
+
+#define APPROX_PIECE (1 << 20)
+#define HH_NAME      48          // heavy hitters keep this much of their text
+
+enum { A_DATE, A_TIME, A_LEVEL, A_COMPONENT, A_CONTENT, A_COLUMNS };  // CSV column - 1
+static const char *approx_names[A_COLUMNS] = { "Date", "Time", "Log Level", "Component", "Content" };
 
-// Simple name→count bucket
 typedef struct {
-    char  name[50]; //atmost the name can be 50 characters
-    size_t count;
-} Counter;
+    double hll_error;    // relative standard error of the distinct counts
+    double cm_error;     // Count-Min overestimate, as a fraction of the rows
+    double cm_delta;     // probability of exceeding cm_error
+    int top;             // heavy hitters kept per column
+} sketch_params;
 
+typedef struct {
+    uint64_t hash, count;
+    char name[HH_NAME];  // first spelling seen, cut to fit
+} heavy_hitter;
 
-// Parse one CSV line into log_entry; returns 1 on success
-int parse_log_line(char *line, LogEntry *log_entry) {
-    char *token;
+typedef struct {
+    int hll_bits;              // 2^hll_bits registers
+    uint32_t cm_width, cm_depth;
+    int top, ntop;
+    uint8_t *registers;
+    uint64_t *counters;        // cm_depth rows of cm_width
+    heavy_hitter *heap;        // min-heap on count
+} col_sketch;
 
-    // Getting LineId
-    //breaks the input string line into smaller tokens (substrings) based on the delimiter ,
-    //After each strtok call, the code checks if token is NULL. If it is NULL, it means 
-    //that either the CSV line is malformed or that there are missing fields. In this case, 
-    //the function returns 0 to indicate failure.
-    token = strtok(line, ",");
-    if (token == NULL) return 0;
-    log_entry->LineId = atoi(token);
+typedef struct {
+    col_sketch cols[A_COLUMNS];
+    uint64_t rows, bad;
+    int failed;                // a sketch could not be allocated
+} approx_counts;
 
-    // Getting Date
-    token = strtok(NULL, ",");
-    if (token == NULL) return 0;
-    strncpy(log_entry->Date, token, sizeof(log_entry->Date)-1);
+// FNV-1a's high bits are weak; HyperLogLog reads them, so finish with murmur3's mixer
+static uint64_t mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
 
-    // Getting Time
-    token = strtok(NULL, ",");
-    if (token == NULL) return 0;
-    strncpy(log_entry->Time, token, sizeof(log_entry->Time)-1);
+static void sketch_free(col_sketch *s) {
+    free(s->registers);
+    free(s->counters);
+    free(s->heap);
+    memset(s, 0, sizeof(*s));
+}
 
-    // Getting Level
-    token = strtok(NULL, ",");
-    if (token == NULL) return 0;
-    strncpy(log_entry->Level, token, sizeof(log_entry->Level)-1);
+static int sketch_init(col_sketch *s, const sketch_params *p) {
+    memset(s, 0, sizeof(*s));
+    // HyperLogLog error is about 1.04 / sqrt(registers)
+    double m = (1.04 / p->hll_error) * (1.04 / p->hll_error);
+    for (s->hll_bits = 4; s->hll_bits < 20 && (double)(1u << s->hll_bits) < m; s->hll_bits++) {}
+    // A Count-Min estimate is at most e/width * rows too high, except with
+    // probability exp(-depth)
+    s->cm_width = (uint32_t)ceil(M_E / p->cm_error);
+    s->cm_depth = (uint32_t)ceil(log(1 / p->cm_delta));
+    s->top = p->top;
+    s->registers = calloc((size_t)1 << s->hll_bits, 1);
+    s->counters = calloc((size_t)s->cm_width * s->cm_depth, sizeof(uint64_t));
+    s->heap = calloc(s->top, sizeof(heavy_hitter));
+    if (!s->registers || !s->counters || !s->heap) {
+        sketch_free(s);
+        return -1;
+    }
+    return 0;
+}
 
-    // Getting Component
-    token = strtok(NULL, ",");
-    if (token == NULL) return 0;
-    strncpy(log_entry->Component, token, sizeof(log_entry->Component)-1);
+static size_t sketch_bytes(const col_sketch *s) {
+    return ((size_t)1 << s->hll_bits) + (size_t)s->cm_width * s->cm_depth * sizeof(uint64_t) +
+           s->top * sizeof(heavy_hitter);
+}
 
-    // Get Content (remaining part of the line)
-    token = strtok(NULL, ",");
-    if (token == NULL) return 0;
-    strncpy(log_entry->Content, token, sizeof(log_entry->Content)-1);
+// Count-Min row i uses h1 + i*h2 (Kirsch-Mitzenmacher), mapped onto the
+// width with a multiply instead of a division
+static inline uint64_t *cm_cell(const col_sketch *s, uint64_t h, uint32_t i) {
+    uint32_t x = (uint32_t)h + i * ((uint32_t)(h >> 32) | 1);
+    return &s->counters[(size_t)i * s->cm_width + (((uint64_t)x * s->cm_width) >> 32)];
+}
 
-    return 1; // Successfully parsed
+static uint64_t cm_estimate(const col_sketch *s, uint64_t h) {
+    uint64_t est = UINT64_MAX;
+    for (uint32_t i = 0; i < s->cm_depth; i++) {
+        uint64_t c = *cm_cell(s, h, i);
+        if (c < est) est = c;
+    }
+    return est;
 }
 
+static void heap_sift_down(col_sketch *s, int i) {
+    for (;;) {
+        int l = 2 * i + 1, m = i;
+        if (l < s->ntop && s->heap[l].count < s->heap[m].count) m = l;
+        if (l + 1 < s->ntop && s->heap[l + 1].count < s->heap[m].count) m = l + 1;
+        if (m == i) return;
+        heavy_hitter tmp = s->heap[i];
+        s->heap[i] = s->heap[m];
+        s->heap[m] = tmp;
+        i = m;
+    }
+}
 
-// Look up key in counters[0..*n), bump its count, or add a new bucket
-//The incr_counter function checks if a given key (e.g., date, time, level) exists
-//in an array of Counter structs. If the key exists, it increments its count. If the key 
-//doesn't exist, it adds a new counter with a count of 1
-void incr_counter(Counter *counters, size_t *n, size_t max, const char *key) {
-    for (size_t i = 0; i < *n; i++) {
-        if (strcmp(counters[i].name, key) == 0) {
-            counters[i].count++;
+// Offer a value with its current estimate to the top-k heap
+static void heap_offer(col_sketch *s, uint64_t h, uint64_t count, const char *name, size_t len, int quoted) {
+    for (int i = 0; i < s->ntop; i++) {
+        if (s->heap[i].hash == h) {
+            s->heap[i].count = count;  // counts only grow, so it can only sink
+            heap_sift_down(s, i);
             return;
         }
     }
-    if (*n < max) {
-        strncpy(counters[*n].name, key, sizeof(counters[*n].name)-1);
-        counters[*n].name[sizeof(counters[*n].name)-1] = '\0';
-        counters[*n].count = 1;
-        (*n)++;
+    int i;
+    if (s->ntop < s->top) {
+        i = s->ntop++;
+    } else if (count > s->heap[0].count) {
+        i = 0;
+    } else {
+        return;
+    }
+    heavy_hitter *e = &s->heap[i];
+    e->hash = h;
+    e->count = count;
+    size_t n = 0;
+    for (size_t k = 0; k < len && n < HH_NAME - 1; k++) {
+        e->name[n++] = name[k];
+        if (quoted && name[k] == '"') k++;
+    }
+    e->name[n] = '\0';
+    if (i == 0) {
+        heap_sift_down(s, 0);
+    } else {
+        for (; i > 0 && s->heap[(i - 1) / 2].count > s->heap[i].count; i = (i - 1) / 2) {
+            heavy_hitter tmp = s->heap[i];
+            s->heap[i] = s->heap[(i - 1) / 2];
+            s->heap[(i - 1) / 2] = tmp;
+        }
     }
 }
 
-// Function to process the CSV file using mmap
-void process_log_file(const char *filename) {
-    // Open the file
+static void sketch_add(col_sketch *s, const csv_field *f) {
+    uint64_t h = mix64(hash_bytes(f->s, f->len));
+
+    // HyperLogLog: the top bits pick a register, which keeps the longest
+    // run of leading zeros seen in the rest
+    uint64_t rest = h << s->hll_bits;
+    uint8_t rank = rest ? (uint8_t)(__builtin_clzll(rest) + 1) : (uint8_t)(64 - s->hll_bits + 1);
+    uint8_t *reg = &s->registers[h >> (64 - s->hll_bits)];
+    if (rank > *reg) *reg = rank;
+
+    uint64_t est = UINT64_MAX;
+    for (uint32_t i = 0; i < s->cm_depth; i++) {
+        uint64_t c = ++*cm_cell(s, h, i);
+        if (c < est) est = c;
+    }
+    // A value at or below the heap minimum is either absent or is the minimum
+    if (s->ntop == s->top && est <= s->heap[0].count) return;
+    heap_offer(s, h, est, f->s, f->len, f->quoted);
+}
+
+static double hll_estimate(const col_sketch *s) {
+    double m = (double)(1u << s->hll_bits), sum = 0;
+    uint32_t zeros = 0;
+    for (uint32_t j = 0; j < (1u << s->hll_bits); j++) {
+        sum += ldexp(1.0, -s->registers[j]);
+        zeros += s->registers[j] == 0;
+    }
+    double alpha = s->hll_bits == 4 ? 0.673 : s->hll_bits == 5 ? 0.697 : s->hll_bits == 6 ? 0.709
+                                                                    : 0.7213 / (1 + 1.079 / m);
+    double e = alpha * m * m / sum;
+    if (e <= 2.5 * m && zeros) e = m * log(m / zeros);  // small range: linear counting
+    return e;
+}
+
+// Fold from into into; both must come from the same sketch_params
+static void sketch_merge(col_sketch *into, const col_sketch *from) {
+    for (uint32_t j = 0; j < (1u << into->hll_bits); j++) {
+        if (from->registers[j] > into->registers[j]) into->registers[j] = from->registers[j];
+    }
+    size_t cells = (size_t)into->cm_width * into->cm_depth;
+    for (size_t i = 0; i < cells; i++) into->counters[i] += from->counters[i];
+
+    // Candidates are both heaps; rank them again by the merged counters
+    heavy_hitter old[2 * into->top];
+    int n = into->ntop;
+    memcpy(old, into->heap, n * sizeof(*old));
+    memcpy(old + n, from->heap, from->ntop * sizeof(*old));
+    n += from->ntop;
+    into->ntop = 0;
+    for (int i = 0; i < n; i++) {
+        heap_offer(into, old[i].hash, cm_estimate(into, old[i].hash), old[i].name, strlen(old[i].name), 0);
+    }
+}
+
+static void approx_free(approx_counts *a) {
+    for (int c = 0; c < A_COLUMNS; c++) sketch_free(&a->cols[c]);
+}
+
+typedef struct {
+    const sketch_params *params;
+    const char *data;
+    size_t size;
+    const query *where;      // bound to dicts, which the workers only read
+    const log_table *dicts;
+} approx_job;
+
+// pf_reduce() hooks: every worker gets its own set of sketches
+static void approx_init(void *partial, void *arg) {
+    const sketch_params *p = ((const approx_job *)arg)->params;
+    approx_counts *a = partial;
+    memset(a, 0, sizeof(*a));
+    for (int c = 0; c < A_COLUMNS; c++) {
+        if (sketch_init(&a->cols[c], p) == -1) a->failed = 1;
+    }
+}
+
+static void approx_combine(void *into, const void *from, void *arg) {
+    (void)arg;
+    approx_counts *a = into, *b = (approx_counts *)from;
+    if (!a->failed && !b->failed) {
+        for (int c = 0; c < A_COLUMNS; c++) sketch_merge(&a->cols[c], &b->cols[c]);
+    }
+    a->rows += b->rows;
+    a->bad += b->bad;
+    a->failed |= b->failed;
+    approx_free(b);
+}
+
+// Sketch the lines that start in pieces [begin, end) of the file
+static void approx_pieces(uint64_t begin, uint64_t end, int worker, void *partial, void *arg) {
+    (void)worker;
+    const approx_job *job = arg;
+    approx_counts *a = partial;
+    if (a->failed) return;
+    const char *file_end = job->data + job->size;
+    for (uint64_t piece = begin; piece < end; piece++) {
+        const char *p = job->data + piece * APPROX_PIECE;
+        const char *stop = file_end - p > APPROX_PIECE ? p + APPROX_PIECE : file_end;
+        if (piece > 0) {
+            // The line running into this piece belongs to the previous one
+            const char *nl = memchr(p - 1, '\n', file_end - (p - 1));
+            if (!nl) continue;
+            p = nl + 1;
+        }
+        while (p < stop) {
+            const char *line_end = memchr(p, '\n', file_end - p);
+            const char *next = line_end ? line_end + 1 : file_end;
+            if (!line_end) line_end = file_end;
+            if (line_end > p && line_end[-1] == '\r') line_end--;
+
+            csv_field f[MAX_FIELDS];
+            row_view row = { .fields = f, .have_content = 1 };
+            if (line_end == p) {
+                // blank line
+            } else if (split_csv(p, line_end, f, F_CONTENT + 1, NULL) <= F_CONTENT ||
+                       !parse_digits(f[0].s, f[0].len, &row.line_id) || !parse_date(&f[1], &row.date) ||
+                       !parse_time(&f[2], &row.time)) {
+                if (!(p == job->data && strncmp(p, "LineId", 6) == 0)) a->bad++;
+            } else if (job->where) {
+                row.level = dict_find(&job->dicts->levels, f[3].s, f[3].len);
+                row.component = dict_find(&job->dicts->components, f[4].s, f[4].len);
+                if (q_eval(job->where, job->where->root, &row) == Q_TRUE) {
+                    a->rows++;
+                    for (int c = 0; c < A_COLUMNS; c++) sketch_add(&a->cols[c], &f[c + 1]);
+                }
+            } else {
+                a->rows++;
+                for (int c = 0; c < A_COLUMNS; c++) sketch_add(&a->cols[c], &f[c + 1]);
+            }
+            p = next;
+        }
+    }
+}
+
+static int cmp_hitters(const void *a, const void *b) {
+    uint64_t x = ((const heavy_hitter *)a)->count, y = ((const heavy_hitter *)b)->count;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static void approx_print(const approx_counts *a, const sketch_params *p, const char *what) {
+    printf("\nApproximate summary of %llu log entries (%llu bad lines) from %s.\n", (unsigned long long)a->rows,
+           (unsigned long long)a->bad, what);
+    printf("Sketches: %.1f KB per column; distinct counts within %.1f%% (1 sd), counts at most %.0f too high "
+           "with %g%% confidence\n", sketch_bytes(&a->cols[0]) / 1024.0, p->hll_error * 100,
+           ceil(p->cm_error * a->rows), (1 - p->cm_delta) * 100);
+    for (int c = 0; c < A_COLUMNS; c++) {
+        const col_sketch *s = &a->cols[c];
+        printf("\n=== %s: ~%.0f distinct ===\n", approx_names[c], hll_estimate(s));
+        heavy_hitter top[s->ntop + 1];
+        memcpy(top, s->heap, s->ntop * sizeof(*top));
+        qsort(top, s->ntop, sizeof(*top), cmp_hitters);
+        for (int i = 0; i < s->ntop; i++) printf("  %-20s: ~%llu\n", top[i].name, (unsigned long long)top[i].count);
+    }
+}
+
+static void print_row(FILE *out, const log_table *t, size_t r) {
+    fprintf(out, "LineId: %llu, Date: %04u-%02u-%02u, Time: %02u:%02u:%02u, Level: %s, Component: %s, Content: %s\n",
+            (unsigned long long)t->line_id[r], t->date[r] / 10000, t->date[r] / 100 % 100, t->date[r] % 100,
+            t->time[r] / 3600, t->time[r] / 60 % 60, t->time[r] % 60, t->levels.names[t->level[r]],
+            t->components.names[t->component[r]], t->content[r]);
+    if (t->miner) fprintf(out, "  -> E%u\n", t->template_id[r] + 1);
+}
+
+/* -------------------------------------------
+   Input mapping
+   ------------------------------------------- */
+
+// -m: how a file gets into memory. A bare mmap() takes a page fault every
+// time the parser reaches a page that is not mapped yet, and on a cold file
+// each of those waits for the disk. The strategies can be combined:
+enum {
+    ACCESS_SEQUENTIAL = 1,   // MADV_SEQUENTIAL: aggressive readahead, pages behind the parser can go
+    ACCESS_WILLNEED   = 2,   // MADV_WILLNEED: start reading the whole file right away
+    ACCESS_POPULATE   = 4,   // MAP_POPULATE: fault every page in before parsing starts
+    ACCESS_PREFETCH   = 8,   // a thread touches pages up to PREFETCH_AHEAD bytes past the parser
+    ACCESS_HUGE       = 16,  // read() into an anonymous staging buffer backed by 2MB pages
+    ACCESS_COLD       = 32,  // drop the file from the page cache first, to time cold runs
+};
+
+#define PREFETCH_AHEAD (16 << 20)
+#define PREFETCH_STEP  (1 << 20)   // the parser reports its position once per MB
+#define HUGE_PAGE      (2 << 20)
+
+static const char *access_names[] = { "seq", "willneed", "populate", "prefetch", "huge", "cold" };
+
+typedef struct {
+    char *data;
+    size_t size;
+    void *map;               // what to munmap: the file mapping or the whole staging buffer
+    size_t map_size;
+    int access;
+    const char *backing;
+    // prefetch thread
+    int prefetching, stop;
+    size_t parsed;           // parser position last reported, under lock
+    size_t next_report;      // parser only: position of the next report
+    pthread_t prefetcher;
+    pthread_mutex_t lock;
+    pthread_cond_t moved;
+    // cost of getting the file through the parser
+    double t0, seconds;
+    struct rusage ru0;
+    long minor_faults, major_faults;
+} input_map;
+
+// Returns the ACCESS_* mask for "seq,prefetch" and the like, or -1
+static int parse_access(const char *list) {
+    int access = 0;
+    while (*list) {
+        size_t len = strcspn(list, ",");
+        int i = 0, n = sizeof(access_names) / sizeof(access_names[0]);
+        while (i < n && !(strlen(access_names[i]) == len && strncmp(list, access_names[i], len) == 0)) i++;
+        if (i < n) access |= 1 << i;
+        else if (!(len == 4 && strncmp(list, "none", 4) == 0)) return -1;
+        list += len + (list[len] == ',');
+    }
+    return access;
+}
+
+static void *prefetch_pages(void *arg) {
+    input_map *in = arg;
+    const volatile char *data = in->data;
+    size_t page = sysconf(_SC_PAGESIZE), at = 0;
+    char sink = 0;
+    while (at < in->size) {
+        pthread_mutex_lock(&in->lock);
+        while (!in->stop && at >= in->parsed + PREFETCH_AHEAD) pthread_cond_wait(&in->moved, &in->lock);
+        size_t limit = in->parsed + PREFETCH_AHEAD < in->size ? in->parsed + PREFETCH_AHEAD : in->size;
+        int stop = in->stop;
+        pthread_mutex_unlock(&in->lock);
+        if (stop) break;
+        // Reading one byte per page is enough to fault it in for both threads
+        for (; at < limit; at += page) sink += data[at];
+    }
+    (void)sink;
+    return NULL;
+}
+
+static int input_map_file(input_map *in, int fd) {
+    // Map the entire file so that it can be accessed directly as one large
+    // block of memory
+    int flags = MAP_PRIVATE | (in->access & ACCESS_POPULATE ? MAP_POPULATE : 0);
+    in->map = mmap(NULL, in->size, PROT_READ, flags, fd, 0);
+    if (in->map == MAP_FAILED) {
+        perror("Error mapping file");
+        return -1;
+    }
+    in->data = in->map;
+    in->map_size = in->size;
+    in->backing = "file mapping";
+    if (in->access & ACCESS_SEQUENTIAL) madvise(in->map, in->size, MADV_SEQUENTIAL);
+    if (in->access & ACCESS_WILLNEED) madvise(in->map, in->size, MADV_WILLNEED);
+    return 0;
+}
+
+static int input_stage(input_map *in, int fd) {
+    size_t size = (in->size + HUGE_PAGE - 1) & ~(size_t)(HUGE_PAGE - 1);
+    in->map_size = size;
+    in->map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    in->backing = "hugetlb staging buffer";
+    if (in->map == MAP_FAILED) {
+        // No hugetlbfs pages reserved: ask for transparent hugepages, which
+        // only back 2MB-aligned ranges, so over-allocate and trim
+        in->map_size = size + HUGE_PAGE;
+        in->map = mmap(NULL, in->map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (in->map == MAP_FAILED) {
+            perror("Error allocating staging buffer");
+            return -1;
+        }
+        char *aligned = (char *)(((uintptr_t)in->map + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1));
+        if (aligned > (char *)in->map) munmap(in->map, aligned - (char *)in->map);
+        munmap(aligned + size, (char *)in->map + in->map_size - aligned - size);
+        in->map = aligned;
+        in->map_size = size;
+        in->backing = madvise(in->map, size, MADV_HUGEPAGE) == 0 ? "THP staging buffer" : "staging buffer";
+#ifdef MADV_POPULATE_WRITE
+        if (in->access & ACCESS_POPULATE) madvise(in->map, size, MADV_POPULATE_WRITE);
+#endif
+    }
+    in->data = in->map;
+    if (in->access & ACCESS_SEQUENTIAL) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (in->access & ACCESS_WILLNEED) posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    for (size_t done = 0; done < in->size;) {
+        ssize_t n = pread(fd, in->data + done, in->size - done, done);
+        if (n <= 0) {
+            if (n == -1 && errno == EINTR) continue;
+            perror("Error reading file");
+            munmap(in->map, in->map_size);
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+// Returns -1 after printing why the file cannot be read. An empty file
+// gives size 0 and no data; input_finish() is still due
+static int input_open(input_map *in, const char *filename, int access) {
+    memset(in, 0, sizeof(*in));
+    in->access = access;
+    in->next_report = SIZE_MAX;
     int fd = open(filename, O_RDONLY);
     if (fd == -1) {
         perror("Error opening file");
-        return;
+        return -1;
     }
-
-    // Get the file size
-    // moves the file pointer to the end of the file and returns the size of the file.
-    //If this fails, it prints an error and exits.
     off_t file_size = lseek(fd, 0, SEEK_END);
     if (file_size == -1) {
         perror("Error getting file size");
         close(fd);
+        return -1;
+    }
+    if (access & ACCESS_COLD) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    in->size = file_size;
+    in->t0 = now_seconds();
+    getrusage(RUSAGE_SELF, &in->ru0);
+    int rc = in->size == 0 ? 0 : access & ACCESS_HUGE ? input_stage(in, fd) : input_map_file(in, fd);
+    close(fd);
+    if (rc == 0 && in->size > 0 && (access & ACCESS_PREFETCH) && !(access & ACCESS_HUGE)) {
+        pthread_mutex_init(&in->lock, NULL);
+        pthread_cond_init(&in->moved, NULL);
+        in->prefetching = pthread_create(&in->prefetcher, NULL, prefetch_pages, in) == 0;
+        if (in->prefetching) in->next_report = PREFETCH_STEP;
+    }
+    return rc;
+}
+
+// The parser has got as far as at; lets the prefetch thread move on
+static inline void input_progress(input_map *in, const char *at) {
+    size_t done = at - in->data;
+    if (done < in->next_report) return;
+    in->next_report = done + PREFETCH_STEP;
+    pthread_mutex_lock(&in->lock);
+    in->parsed = done;
+    pthread_cond_signal(&in->moved);
+    pthread_mutex_unlock(&in->lock);
+}
+
+// Stops prefetching, takes the time and fault counts and unmaps the input
+static void input_finish(input_map *in) {
+    if (in->prefetching) {
+        pthread_mutex_lock(&in->lock);
+        in->stop = 1;
+        pthread_cond_signal(&in->moved);
+        pthread_mutex_unlock(&in->lock);
+        pthread_join(in->prefetcher, NULL);
+        pthread_mutex_destroy(&in->lock);
+        pthread_cond_destroy(&in->moved);
+        in->prefetching = 0;
+    }
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    in->seconds = now_seconds() - in->t0;
+    in->minor_faults = ru.ru_minflt - in->ru0.ru_minflt;
+    in->major_faults = ru.ru_majflt - in->ru0.ru_majflt;
+    if (in->map) munmap(in->map, in->map_size);
+    in->map = NULL;
+    in->data = NULL;
+}
+
+static void input_report(const input_map *in) {
+    printf("Input: %s (", in->backing ? in->backing : "empty");
+    int n = 0;
+    for (size_t i = 0; i < sizeof(access_names) / sizeof(access_names[0]); i++)
+        if (in->access & (1 << i)) printf("%s%s", n++ ? "+" : "", access_names[i]);
+    printf("%s), %.1f ms, %ld minor / %ld major page faults\n", n ? "" : "none", in->seconds * 1e3,
+           in->minor_faults, in->major_faults);
+}
+
+typedef struct {
+    int print_rows;
+    int count_only;   // report how many rows match and keep none of them
+    query *where;     // NULL: every row
+    int build_index;
+    const char *search;
+    int templates;          // mine Content into templates
+    int raw;                // inputs are plain log lines, not CSV
+    int approx;
+    sketch_params sketch;
+    pf_pool *pool;          // parses -a files
+    approx_counts *total;   // -a sketches merged over every file so far
+    int access;             // -m ACCESS_* strategy for reading the input
+    int input_stats;        // -m given: report time and page faults per file
+} run_options;
+
+// Function to process the CSV file using mmap
+void process_log_file(const char *filename, const run_options *opt) {
+    // Open and map the file, the way -m asks for
+    input_map in;
+    if (input_open(&in, filename, opt->access) == -1) return;
+    if (in.size == 0) {
+        printf("%s is empty\n", filename);
+        input_finish(&in);
         return;
     }
-    lseek(fd, 0, SEEK_SET);  // Reset to the beginning
+    const char *file_data = in.data;
 
-    // Map the file into memory
-    //utilizing mmap
-    //maps the entire file into memory so that it can be accessed directly as a large 
-    //block of memory.
-    char *file_data = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
-    if (file_data == MAP_FAILED) {
-        perror("Error mapping file");
-        close(fd);
+    log_table table = { 0 };
+    template_miner miner;
+    size_t line_no = 0, bad = 0, parsed = 0, matched = 0;
+    if ((opt->templates && miner_init(&miner) == -1) || (opt->where && query_bind(opt->where, &table, 1) == -1)) {
+        fprintf(stderr, "Out of memory\n");
+        if (opt->templates) miner_free(&miner);
+        input_finish(&in);
         return;
     }
-    close(fd); //Closes the file
-
-    // Prepare counters for date, time, level, and component counts
-    Counter date_counts[MAX_UNIQUE] = {0};
-    Counter time_counts[MAX_UNIQUE] = {0};
-    Counter level_counts[MAX_UNIQUE] = {0};
-    Counter component_counts[MAX_UNIQUE] = {0};
-
-    size_t n_dates = 0, n_times = 0, n_levels = 0, n_components = 0;
-    size_t total = 0;
-
-    char *line_start = file_data;
-    char *line_end = strchr(line_start, '\n');
-    LogEntry log_entry;
-    char line_buffer[MAX_LINE_LENGTH];
-
-    // Process the file line by line
-    while (line_end != NULL) {
-        size_t len = line_end - line_start;
-        if (len >= sizeof(line_buffer)) len = sizeof(line_buffer)-1;
-        strncpy(line_buffer, line_start, len);
-        line_buffer[len] = '\0';  // Safe null-termination
-
-        if (parse_log_line(line_buffer, &log_entry)) {
-            total++;
-            incr_counter(date_counts, &n_dates, MAX_UNIQUE, log_entry.Date);
-            incr_counter(time_counts, &n_times, MAX_UNIQUE, log_entry.Time);
-            incr_counter(level_counts, &n_levels, MAX_UNIQUE, log_entry.Level);
-            incr_counter(component_counts, &n_components, MAX_UNIQUE, log_entry.Component);
-
-            // Output the full row information
-            printf("LineId: %d, Date: %s, Time: %s, Level: %s, Component: %s, Content: %s\n",
-                log_entry.LineId, log_entry.Date, log_entry.Time, log_entry.Level, log_entry.Component, log_entry.Content);
-        } else {
-            fprintf(stderr, "Error parsing line %zu\n", total+1);
+    if (opt->templates) table.miner = &miner;
+    const char *line_start = file_data;
+    const char *file_end = file_data + in.size;
+
+    // Process the file line by line. The mapping is not NUL-terminated, so
+    // lines are found with memchr() bounded by the file size
+    while (line_start < file_end) {
+        input_progress(&in, line_start);
+        const char *line_end = memchr(line_start, '\n', file_end - line_start);
+        const char *next = line_end ? line_end + 1 : file_end;
+        if (!line_end) line_end = file_end;
+        if (line_end > line_start && line_end[-1] == '\r') line_end--;
+        line_no++;
+
+        int rc = line_end > line_start ? parse_log_line(line_start, line_end, &table, opt->where, !opt->count_only) : 0;
+        if (rc < 0) {
+            fprintf(stderr, "Out of memory at line %zu\n", line_no);
+            break;
         }
+        // The first line of the structured CSVs is the column header
+        if (rc == 0 && line_end > line_start && !(line_no == 1 && strncmp(line_start, "LineId", 6) == 0)) {
+            fprintf(stderr, "Error parsing line %zu\n", line_no);
+            bad++;
+        }
+        parsed += rc > 0;
+        matched += rc == 1;
+        line_start = next;
+    }
+    input_finish(&in);
+
+    if (opt->count_only) {
+        printf("%zu of %zu log entries match in %s (%zu bad lines).\n", matched, parsed, filename, bad);
+        if (opt->input_stats) input_report(&in);
+        table_free(&table);
+        if (opt->templates) miner_free(&miner);
+        return;
+    }
+
+    key_counter date_counts = { 0 }, time_counts = { 0 };
+    size_t *level_counts = calloc(table.levels.count + 1, sizeof(size_t));
+    size_t *component_counts = calloc(table.components.count + 1, sizeof(size_t));
+    if (!level_counts || !component_counts) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t r = 0; r < table.rows; r++) {
+        incr_counter(&date_counts, table.date[r]);
+        incr_counter(&time_counts, table.time[r]);
+        level_counts[table.level[r]]++;
+        component_counts[table.component[r]]++;
 
-        // Move to the next line
-        line_start = line_end + 1;
-        line_end = strchr(line_start, '\n');
+        // Output the full row information
+        if (opt->print_rows) print_row(stdout, &table, r);
     }
 
     // Print the summary statistics
-    printf("\nProcessed %zu log entries.\n\n", total);
+    if (opt->where)
+        printf("\nProcessed %zu log entries, %zu matched (%zu bad lines) from %s.\n", parsed, table.rows, bad, filename);
+    else
+        printf("\nProcessed %zu log entries (%zu bad lines) from %s.\n", table.rows, bad, filename);
+    if (opt->input_stats) input_report(&in);
+    printf("Resident size: %.1f KB in columns + arena (fixed 584-byte rows would need %.1f KB)\n\n",
+           table_bytes(&table) / 1024.0, table.rows * 584 / 1024.0);
 
     printf("=== Date Counts ===\n");
-    for (size_t i = 0; i < n_dates; i++) {
-        printf("  %-10s: %zu\n", date_counts[i].name, date_counts[i].count);
+    for (size_t i = 0; i < date_counts.n; i++) {
+        uint32_t d = date_counts.keys[i];
+        printf("  %04u-%02u-%02u: %zu\n", d / 10000, d / 100 % 100, d % 100, date_counts.counts[i]);
     }
 
     printf("\n=== Time Counts ===\n");
-    for (size_t i = 0; i < n_times; i++) {
-        printf("  %-8s: %zu\n", time_counts[i].name, time_counts[i].count);
+    for (size_t i = 0; i < time_counts.n; i++) {
+        uint32_t t = time_counts.keys[i];
+        printf("  %02u:%02u:%02u: %zu\n", t / 3600, t / 60 % 60, t % 60, time_counts.counts[i]);
     }
 
     printf("\n=== Log Level Counts ===\n");
-    for (size_t i = 0; i < n_levels; i++) {
-        printf("  %-10s: %zu\n", level_counts[i].name, level_counts[i].count);
+    for (uint32_t i = 0; i < table.levels.count; i++) {
+        if (level_counts[i]) printf("  %-10s: %zu\n", table.levels.names[i], level_counts[i]);
     }
 
     printf("\n=== Component Counts ===\n");
-    for (size_t i = 0; i < n_components; i++) {
-        printf("  %-20s: %zu\n", component_counts[i].name, component_counts[i].count);
+    for (uint32_t i = 0; i < table.components.count; i++) {
+        if (component_counts[i]) printf("  %-20s: %zu\n", table.components.names[i], component_counts[i]);
+    }
+
+    if (table.miner) print_template_counts(table.miner);
+
+    if (opt->build_index) {
+        char *path = malloc(strlen(filename) + 5);
+        uint64_t terms;
+        size_t bytes;
+        double t0 = now_seconds();
+        if (path) sprintf(path, "%s.idx", filename);
+        if (!path || index_write(&table, path, &terms, &bytes) == -1) {
+            perror(path ? path : "malloc");
+        } else {
+            printf("\nIndexed %zu log entries into %s: %llu terms, %.1f KB in %.1f ms\n", table.rows, path,
+                   (unsigned long long)terms, bytes / 1024.0, (now_seconds() - t0) * 1e3);
+        }
+        free(path);
+    }
+
+    // Clean up: columns, dictionaries and every Content string in one go
+    counter_free(&date_counts);
+    counter_free(&time_counts);
+    free(level_counts);
+    free(component_counts);
+    table_free(&table);
+    if (opt->templates) miner_free(&miner);
+}
+
+
+
+
+// -a: sketch every column of filename in parallel and fold it into opt->total
+void approx_log_file(const char *filename, const run_options *opt) {
+    // The workers take pieces in no fixed order, so there is no single
+    // parser position for a prefetch thread to run ahead of
+    input_map in;
+    if (input_open(&in, filename, opt->access & ~ACCESS_PREFETCH) == -1) return;
+    if (in.size == 0) {
+        printf("%s is empty\n", filename);
+        input_finish(&in);
+        return;
+    }
+    const char *file_data = in.data;
+    size_t file_size = in.size;
+
+    // The filter's literals still need dictionary ids; the workers only look them up
+    log_table dicts = { 0 };
+    approx_job job = { &opt->sketch, file_data, (size_t)file_size, opt->where, &dicts };
+    approx_counts result;
+    double t0 = now_seconds();
+    int rc = opt->where ? query_bind(opt->where, &dicts, 1) : 0;
+    if (rc == 0) {
+        rc = pf_reduce(opt->pool, 0, ((size_t)file_size + APPROX_PIECE - 1) / APPROX_PIECE, 1, approx_pieces, &job,
+                       sizeof(result), approx_init, approx_combine, &result);
+    }
+    double t1 = now_seconds();
+    input_finish(&in);
+    table_free(&dicts);
+    if (rc == 0 && result.failed) approx_free(&result);
+    if (rc == -1 || result.failed) {
+        fprintf(stderr, "Out of memory for the sketches of %s\n", filename);
+        return;
+    }
+
+    approx_print(&result, &opt->sketch, filename);
+    printf("\n%d threads, %.1f ms\n", pf_threads(opt->pool), (t1 - t0) * 1e3);
+    if (opt->input_stats) input_report(&in);
+    if (opt->total->rows == 0 && opt->total->bad == 0) {
+        approx_free(opt->total);
+        *opt->total = result;
+    } else {
+        approx_combine(opt->total, &result, NULL);
+    }
+}
+
+// -R: every line of a raw log is one message to mine
+void mine_raw_file(const char *filename, const run_options *opt) {
+    input_map in;
+    if (input_open(&in, filename, opt->access) == -1) return;
+    if (in.size == 0) {
+        printf("%s is empty\n", filename);
+        input_finish(&in);
+        return;
+    }
+
+    template_miner miner;
+    if (miner_init(&miner) == -1) {
+        fprintf(stderr, "Out of memory\n");
+        input_finish(&in);
+        return;
+    }
+    size_t lines = 0;
+    double t0 = now_seconds();
+    for (const char *p = in.data, *end = in.data + in.size; p < end;) {
+        input_progress(&in, p);
+        const char *line_end = memchr(p, '\n', end - p);
+        const char *next = line_end ? line_end + 1 : end;
+        if (!line_end) line_end = end;
+        if (line_end > p && line_end[-1] == '\r') line_end--;
+        if (line_end > p) {
+            int64_t id = miner_add(&miner, p, line_end - p);
+            if (id < 0) {
+                fprintf(stderr, "Out of memory at line %zu\n", lines + 1);
+                break;
+            }
+            if (opt->print_rows) printf("%zu: E%u\n", lines + 1, (uint32_t)id + 1);
+        }
+        lines++;
+        p = next;
+    }
+    double secs = now_seconds() - t0;
+    input_finish(&in);
+
+    printf("\nMined %zu lines of %s in %.1f ms (%.0f lines/s, %.1f MB/s)\n", lines, filename, secs * 1e3,
+           lines / secs, in.size / secs / 1e6);
+    if (opt->input_stats) input_report(&in);
+    print_template_counts(&miner);
+    miner_free(&miner);
+}
+
+// Answer -s from file.idx, or file.csv.idx for a CSV
+void search_log_index(const char *filename, const run_options *opt) {
+    size_t len = strlen(filename);
+    char *path = malloc(len + 5);
+    if (!path) {
+        perror("malloc");
+        return;
+    }
+    if (len > 4 && strcmp(filename + len - 4, ".idx") == 0) strcpy(path, filename);
+    else sprintf(path, "%s.idx", filename);
+
+    double t0 = now_seconds();
+    log_index ix;
+    if (index_open(&ix, path) == -1) {
+        fprintf(stderr, "Error opening index %s: %s (build it with -i)\n", path, strerror(errno));
+        free(path);
+        return;
+    }
+    search_parser sp = { opt->search, &ix, 0 };
+    id_list hits = { 0 };
+    search_or(&sp, &hits);
+    while (*sp.p == ' ' || *sp.p == '\t') sp.p++;
+    if (*sp.p) search_error(&sp, "unexpected text");
+    double t1 = now_seconds();
+
+    if (!sp.failed) {
+        if (opt->print_rows && !opt->count_only) {
+            for (size_t i = 0; i < hits.n; i++) printf("LineId: %llu\n", (unsigned long long)hits.ids[i]);
+        }
+        printf("%zu of %llu log entries match in %s (%.3f ms)\n", hits.n, (unsigned long long)ix.h->rows, path,
+               (t1 - t0) * 1e3);
+    }
+    free(hits.ids);
+    index_close(&ix);
+    free(path);
+}
+
+/* -------------------------------------------
+   Daemon mode
+   ------------------------------------------- */
+
+// -D socket keeps the files parsed in memory, follows them as they grow and
+// answers one request per connection on a Unix domain socket:
+//   STATS            rows, bad lines and per-level/component counts per file
+//   COUNT <query>    how many rows match a -w query
+//   ROWS <query>     the matching rows, printed like the normal output
+// The reply is text ending at EOF; its first line is "OK ..." or "ERR ...".
+// ROWS writes the rows into a memfd and passes the descriptor along with
+// the reply (SCM_RIGHTS), so a big result is mapped by the client instead
+// of being copied through the socket. Files are watched with inotify:
+// appended lines are parsed on the spot, and a file that shrinks or is
+// replaced (log rotation) is parsed again from the start.
+// -C socket "request" is the matching client.
+
+#define MAX_REQUEST  4096
+#define WATCH_EVENTS (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF)
+
+typedef struct {
+    const char *path;
+    int wd;                  // inotify watch, -1 while the file is missing
+    ino_t inode;
+    off_t offset;            // bytes parsed so far; always at a line start
+    size_t lines, bad;
+    log_table table;
+    key_counter dates, times;
+    size_t *level_counts, *component_counts;
+    uint32_t level_cap, component_cap;
+} warm_file;
+
+static volatile sig_atomic_t daemon_stop;
+
+static void daemon_signal(int sig) {
+    (void)sig;
+    daemon_stop = 1;
+}
+
+static void warm_reset(warm_file *w) {
+    table_free(&w->table);
+    counter_free(&w->dates);
+    counter_free(&w->times);
+    free(w->level_counts);
+    free(w->component_counts);
+    const char *path = w->path;
+    int wd = w->wd;
+    memset(w, 0, sizeof(*w));
+    w->path = path;
+    w->wd = wd;
+}
+
+// Make counts[] cover ids below need
+static int grow_counts(size_t **counts, uint32_t *cap, uint32_t need) {
+    if (need <= *cap) return 0;
+    uint32_t n = *cap ? *cap : 16;
+    while (n < need) n *= 2;
+    size_t *c = realloc(*counts, n * sizeof(*c));
+    if (!c) return -1;
+    memset(c + *cap, 0, (n - *cap) * sizeof(*c));
+    *counts = c;
+    *cap = n;
+    return 0;
+}
+
+// Parse the complete lines appended since the last call; -1 when out of memory
+static int warm_ingest(warm_file *w) {
+    int fd = open(w->path, O_RDONLY);
+    if (fd == -1) return 0;  // gone for now; the watch is set up again when it is back
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return 0;
+    }
+    if (st.st_ino != w->inode || st.st_size < w->offset) {
+        warm_reset(w);  // replaced or truncated
+        w->inode = st.st_ino;
+    }
+    if (st.st_size == w->offset) {
+        close(fd);
+        return 0;
+    }
+    char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return 0;
+
+    int rc = 0;
+    const char *p = data + w->offset, *end = data + st.st_size;
+    while (p < end) {
+        const char *line_end = memchr(p, '\n', end - p);
+        if (!line_end) break;  // still being written; wait for the newline
+        const char *next = line_end + 1;
+        if (line_end > p && line_end[-1] == '\r') line_end--;
+        w->lines++;
+        int r = line_end > p ? parse_log_line(p, line_end, &w->table, NULL, 1) : 0;
+        if (r == 1) {
+            log_table *t = &w->table;
+            size_t row = t->rows - 1;
+            if (grow_counts(&w->level_counts, &w->level_cap, t->levels.count) == -1 ||
+                grow_counts(&w->component_counts, &w->component_cap, t->components.count) == -1)
+                r = -1;
+            else {
+                incr_counter(&w->dates, t->date[row]);
+                incr_counter(&w->times, t->time[row]);
+                w->level_counts[t->level[row]]++;
+                w->component_counts[t->component[row]]++;
+            }
+        }
+        if (r < 0) {
+            rc = -1;
+            break;
+        }
+        if (r == 0 && line_end > p && !(p == data && strncmp(p, "LineId", 6) == 0)) w->bad++;
+        p = next;
+    }
+    w->offset = p - data;
+    munmap(data, st.st_size);
+    return rc;
+}
+
+// q_eval() over a whole table, a column at a time: bits gets one bit per
+// row. Only rows set in live need a right answer, so "and"/"or" hand the
+// still undecided rows to their second operand and Content is only
+// searched for those. -1 when out of memory
+static int q_eval_columns(const query *q, int i, const log_table *t, const uint64_t *live, uint64_t *bits) {
+    const q_node *node = &q->nodes[i];
+    size_t rows = t->rows, words = (rows + 63) / 64;
+    switch (node->kind) {
+    case Q_AND:
+    case Q_OR: {
+        uint64_t *open = malloc(words * sizeof(uint64_t) + 1), *right = malloc(words * sizeof(uint64_t) + 1);
+        int rc = open && right ? q_eval_columns(q, node->left, t, live, bits) : -1;
+        if (rc == 0) {
+            for (size_t w = 0; w < words; w++) open[w] = live[w] & (node->kind == Q_AND ? bits[w] : ~bits[w]);
+            rc = q_eval_columns(q, node->right, t, open, right);
+        }
+        if (rc == 0) {
+            for (size_t w = 0; w < words; w++) bits[w] = node->kind == Q_AND ? bits[w] & right[w] : bits[w] | right[w];
+        }
+        free(open);
+        free(right);
+        return rc;
+    }
+    case Q_NOT: {
+        if (q_eval_columns(q, node->left, t, live, bits) == -1) return -1;
+        for (size_t w = 0; w < words; w++) bits[w] = ~bits[w];
+        return 0;
+    }
+    // Builds each word of bits in a register, 64 rows at a time
+#define FILL_BITS(pred)                                                     \
+    for (size_t w = 0; w < words; w++) {                                    \
+        size_t base = w * 64, n = rows - base < 64 ? rows - base : 64;      \
+        uint64_t word = 0;                                                  \
+        for (size_t j = 0; j < n; j++) {                                    \
+            size_t r = base + j;                                            \
+            word |= (uint64_t)(pred) << j;                                  \
+        }                                                                   \
+        bits[w] = word;                                                     \
+    }
+    case Q_CMP: {
+        uint64_t v = node->value;
+        // One tight loop per column and operator, so the compiler can vectorize it
+#define CMP_LOOP(col, OP) FILL_BITS(t->col[r] OP v)
+#define CMP_COLUMN(col)                                 \
+        switch (node->op) {                             \
+        case OP_EQ: CMP_LOOP(col, ==); break;           \
+        case OP_NE: CMP_LOOP(col, !=); break;           \
+        case OP_LT: CMP_LOOP(col, <); break;            \
+        case OP_LE: CMP_LOOP(col, <=); break;           \
+        case OP_GT: CMP_LOOP(col, >); break;            \
+        default:    CMP_LOOP(col, >=); break;           \
+        }
+        if (node->field == F_LINEID) {
+            CMP_COLUMN(line_id)
+        } else if (node->field == F_DATE) {
+            CMP_COLUMN(date)
+        } else {
+            CMP_COLUMN(time)
+        }
+#undef CMP_COLUMN
+#undef CMP_LOOP
+        return 0;
+    }
+    default:
+        break;
+    }
+
+    memset(bits, 0, words * sizeof(uint64_t));
+    if (node->kind == Q_CONTAINS && node->field == F_CONTENT) {
+        for (size_t w = 0; w < words; w++) {
+            for (uint64_t m = live[w]; m; m &= m - 1) {
+                size_t r = w * 64 + __builtin_ctzll(m);
+                if (r < rows && contains_bytes(t->content[r], t->content_len[r], node->strings[0], node->needle_len))
+                    bits[w] |= 1ULL << (r % 64);
+            }
+        }
+        return 0;
+    }
+
+    // Level/Component: decide once per dictionary entry, then look rows up
+    const string_dict *d = node->field == F_LEVEL ? &t->levels : &t->components;
+    uint8_t *match = malloc(d->count + 1);
+    if (!match) return -1;
+    for (uint32_t id = 0; id < d->count; id++) {
+        if (node->kind == Q_CONTAINS) {
+            match[id] = (uint8_t)contains_bytes(d->names[id], d->lengths[id], node->strings[0], node->needle_len);
+        } else {
+            int hit = id / 64 < node->id_words && (node->ids[id / 64] >> (id % 64) & 1);
+            match[id] = (uint8_t)(node->op == OP_NE ? !hit : hit);
+        }
+    }
+    if (node->field == F_LEVEL) {
+        FILL_BITS(match[t->level[r]])
+    } else {
+        FILL_BITS(match[t->component[r]])
+    }
+#undef FILL_BITS
+    free(match);
+    return 0;
+}
+
+// Rows of t that match q, as a bitmap the caller frees; NULL when out of memory
+static uint64_t *table_select(const query *q, const log_table *t) {
+    size_t words = (t->rows + 63) / 64;
+    uint64_t *live = malloc(words * sizeof(uint64_t) + 1), *bits = malloc(words * sizeof(uint64_t) + 1);
+    if (live && bits) {
+        memset(live, 0xff, words * sizeof(uint64_t));
+        if (t->rows % 64) live[words - 1] = (1ULL << (t->rows % 64)) - 1;
+        if (q_eval_columns(q, q->root, t, live, bits) == 0) {
+            for (size_t w = 0; w < words; w++) bits[w] &= live[w];
+            free(live);
+            return bits;
+        }
+    }
+    free(live);
+    free(bits);
+    return NULL;
+}
+
+// Send text, and fd (unless it is -1) along with it
+static void send_reply(int sock, const char *text, size_t len, int fd) {
+    struct iovec iov = { (void *)text, len };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+    if (fd >= 0) {
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c), &fd, sizeof(int));
+    }
+    ssize_t n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    // Only the first chunk carries the descriptor; the rest is plain text
+    while (n > 0 && (size_t)n < len) {
+        text += n;
+        len -= n;
+        n = send(sock, text, len, MSG_NOSIGNAL);
+    }
+}
+
+static void handle_request(int sock, warm_file *files, int nfiles) {
+    char req[MAX_REQUEST];
+    size_t len = 0;
+    ssize_t n;
+    while (len < sizeof(req) - 1 && (n = read(sock, req + len, sizeof(req) - 1 - len)) > 0) {
+        len += n;
+        if (memchr(req + len - n, '\n', n)) break;
+    }
+    req[len] = '\0';
+    req[strcspn(req, "\r\n")] = '\0';
+
+    char *reply = NULL;
+    size_t reply_len = 0;
+    FILE *out = open_memstream(&reply, &reply_len);
+    if (!out) return;
+    int fd = -1;
+    double t0 = now_seconds();
+
+    if (strcmp(req, "STATS") == 0) {
+        fprintf(out, "OK %d files\n", nfiles);
+        for (int i = 0; i < nfiles; i++) {
+            warm_file *w = &files[i];
+            fprintf(out, "%s: %zu rows, %zu bad lines, %lld bytes read, %zu dates, %zu times\n", w->path,
+                    w->table.rows, w->bad, (long long)w->offset, w->dates.n, w->times.n);
+            for (uint32_t k = 0; k < w->table.levels.count && k < w->level_cap; k++) {
+                if (w->level_counts[k]) fprintf(out, "  level %-20s: %zu\n", w->table.levels.names[k], w->level_counts[k]);
+            }
+            for (uint32_t k = 0; k < w->table.components.count && k < w->component_cap; k++) {
+                if (w->component_counts[k])
+                    fprintf(out, "  component %-16s: %zu\n", w->table.components.names[k], w->component_counts[k]);
+            }
+        }
+    } else if (strncmp(req, "COUNT ", 6) == 0 || strncmp(req, "ROWS ", 5) == 0) {
+        int rows_wanted = req[0] == 'R';
+        query q;
+        if (query_compile(&q, req + (rows_wanted ? 5 : 6)) == -1) {
+            fprintf(out, "ERR %s\n", query_error);
+        } else {
+            FILE *rows = NULL;
+            if (rows_wanted) {
+                fd = memfd_create("group_project-rows", MFD_CLOEXEC);
+                int copy = fd == -1 ? -1 : dup(fd);
+                rows = copy == -1 ? NULL : fdopen(copy, "w");
+                if (!rows && copy != -1) close(copy);
+            }
+            size_t matched = 0, total = 0;
+            int failed = rows_wanted && !rows;
+            for (int i = 0; i < nfiles && !failed; i++) {
+                log_table *t = &files[i].table;
+                if (query_bind(&q, t, 0) == -1) {
+                    failed = 1;
+                    break;
+                }
+                uint64_t *bits = table_select(&q, t);
+                if (!bits) {
+                    failed = 1;
+                    break;
+                }
+                for (size_t w = 0; w < (t->rows + 63) / 64; w++) {
+                    matched += __builtin_popcountll(bits[w]);
+                    for (uint64_t m = rows ? bits[w] : 0; m; m &= m - 1) print_row(rows, t, w * 64 + __builtin_ctzll(m));
+                }
+                free(bits);
+                total += t->rows;
+            }
+            long bytes = 0;
+            if (rows) {
+                if (fflush(rows) != 0) failed = 1;
+                bytes = ftell(rows);
+                fclose(rows);
+            }
+            if (failed) {
+                fprintf(out, "ERR out of memory\n");
+                if (fd >= 0) close(fd);
+                fd = -1;
+            } else if (rows_wanted) {
+                fprintf(out, "OK %zu of %zu rows, %ld bytes in shared memory (%.3f ms)\n", matched, total, bytes,
+                        (now_seconds() - t0) * 1e3);
+            } else {
+                fprintf(out, "OK %zu of %zu rows (%.3f ms)\n", matched, total, (now_seconds() - t0) * 1e3);
+            }
+            query_free(&q);
+        }
+    } else {
+        fprintf(out, "ERR unknown request; use STATS, COUNT <query> or ROWS <query>\n");
+    }
+    fclose(out);
+    send_reply(sock, reply, reply_len, fd);
+    if (fd >= 0) close(fd);
+    free(reply);
+}
+
+// -D: parse the files, then serve requests and follow the files until SIGINT/SIGTERM
+int run_daemon(const char *socket_path, const char **paths, int nfiles) {
+    warm_file *files = calloc(nfiles, sizeof(*files));
+    int ino = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (!files || ino == -1 || listener == -1 || strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Could not set up the daemon\n");
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+    unlink(socket_path);  // left over from a daemon that was killed
+    if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(listener, 16) == -1) {
+        perror(socket_path);
+        return 1;
     }
 
-    // Clean up mmap
-    munmap(file_data, file_size);
+    double t0 = now_seconds();
+    for (int i = 0; i < nfiles; i++) {
+        files[i].path = paths[i];
+        files[i].wd = inotify_add_watch(ino, paths[i], WATCH_EVENTS);
+        if (warm_ingest(&files[i]) == -1) fprintf(stderr, "Out of memory reading %s\n", paths[i]);
+        printf("%s: %zu rows\n", paths[i], files[i].table.rows);
+    }
+    printf("Ready in %.1f ms; listening on %s\n", (now_seconds() - t0) * 1e3, socket_path);
+    fflush(stdout);
+
+    struct sigaction sa = { .sa_handler = daemon_signal };
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    while (!daemon_stop) {
+        struct pollfd pfd[2] = { { listener, POLLIN, 0 }, { ino, POLLIN, 0 } };
+        if (poll(pfd, 2, 1000) == -1 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+
+        if (pfd[1].revents & POLLIN) {
+            char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+            ssize_t n;
+            while ((n = read(ino, buf, sizeof(buf))) > 0) {
+                for (char *p = buf; p < buf + n; p += sizeof(struct inotify_event) + ((struct inotify_event *)p)->len) {
+                    const struct inotify_event *ev = (const struct inotify_event *)p;
+                    for (int i = 0; i < nfiles; i++) {
+                        if (files[i].wd != ev->wd) continue;
+                        if (ev->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED)) {
+                            // Rotated away: look for a new file under the name below
+                            inotify_rm_watch(ino, files[i].wd);
+                            files[i].wd = -1;
+                        } else if (warm_ingest(&files[i]) == -1) {
+                            fprintf(stderr, "Out of memory reading %s\n", files[i].path);
+                        }
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < nfiles; i++) {
+            if (files[i].wd != -1) continue;
+            files[i].wd = inotify_add_watch(ino, files[i].path, WATCH_EVENTS);
+            if (files[i].wd != -1 && warm_ingest(&files[i]) == -1)
+                fprintf(stderr, "Out of memory reading %s\n", files[i].path);
+        }
+
+        if (pfd[0].revents & POLLIN) {
+            int client = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+            if (client == -1) continue;
+            struct timeval tv = { 1, 0 };  // a stuck client must not stall the daemon
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+            handle_request(client, files, nfiles);
+            close(client);
+        }
+    }
+
+    close(listener);
+    unlink(socket_path);
+    close(ino);
+    for (int i = 0; i < nfiles; i++) warm_reset(&files[i]);
+    free(files);
+    return 0;
 }
 
+// -C: send one request, print the reply and any shared-memory rows
+int run_client(const char *socket_path, const char *request) {
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (sock == -1 || strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Bad socket path\n");
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+    double t0 = now_seconds();
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        perror(socket_path);
+        return 1;
+    }
+    size_t len = strlen(request);
+    if (write(sock, request, len) != (ssize_t)len || write(sock, "\n", 1) != 1) {
+        perror("write");
+        return 1;
+    }
+
+    // The descriptor, if any, comes with the first bytes of the reply
+    char buf[65536];
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct iovec iov = { buf, sizeof(buf) };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1, .msg_control = control.buf,
+                          .msg_controllen = sizeof(control.buf) };
+    ssize_t n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    int fd = -1;
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) memcpy(&fd, CMSG_DATA(c), sizeof(int));
+    }
+    char *reply = NULL;
+    size_t reply_len = 0;
+    FILE *text = open_memstream(&reply, &reply_len);
+    while (n > 0 && text) {
+        fwrite(buf, 1, n, text);
+        n = read(sock, buf, sizeof(buf));
+    }
+    if (text) fclose(text);
+    double t1 = now_seconds();
+    close(sock);
 
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            char *rows = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (rows != MAP_FAILED) {
+                fwrite(rows, 1, st.st_size, stdout);
+                munmap(rows, st.st_size);
+            }
+        }
+        close(fd);
+    }
+    if (reply) fwrite(reply, 1, reply_len, stdout);
+    fprintf(stderr, "(%.3f ms round trip)\n", (t1 - t0) * 1e3);
+    int ok = reply && strncmp(reply, "OK", 2) == 0;
+    free(reply);
+    return ok ? 0 : 1;
+}
 
+static void usage(void) {
+    fprintf(stderr, "Usage: ./group_project [-q] [-c] [-w query] [-i] [-s search] [-T] [-R] [-m access]\n"
+                    "                       [-a [-u err] [-e err] [-d delta] [-k top] [-t threads]] [file.csv ...]\n"
+                    "       ./group_project -D socket [file.csv ...]\n"
+                    "       ./group_project -C socket \"STATS\" | \"COUNT query\" | \"ROWS query\"\n");
+    exit(EXIT_FAILURE);
+}
 
-int main() {
-    const char *log_file = "/home/kali/Downloads/Windows_2k.log_structured.csv";  
-    process_log_file(log_file);
+int main(int argc, char *argv[]) {
+    run_options opt = { 1, 0, NULL, 0, NULL, 0, 0, 0, { 0.01, 0.0005, 0.01, 10 }, NULL, NULL, 0, 0 };
+    approx_counts total = { 0 };
+    int threads = 0, files = 0;
+    query where;
+    int argi = 1;
+    if (argc > 1 && strcmp(argv[1], "-C") == 0) {
+        if (argc != 4) usage();
+        return run_client(argv[2], argv[3]);
+    }
+    if (argc > 1 && strcmp(argv[1], "-D") == 0) {
+        if (argc < 3) usage();
+        static const char *default_files[] = { DEFAULT_LOG_FILE };
+        return argc == 3 ? run_daemon(argv[2], default_files, 1)
+                         : run_daemon(argv[2], (const char **)argv + 3, argc - 3);
+    }
+    for (; argi < argc && argv[argi][0] == '-'; argi++) {
+        if (strcmp(argv[argi], "-q") == 0) opt.print_rows = 0;
+        else if (strcmp(argv[argi], "-c") == 0) opt.count_only = 1;
+        else if (strcmp(argv[argi], "-w") == 0 && argi + 1 < argc) {
+            if (query_compile(&where, argv[++argi]) == -1) {
+                fprintf(stderr, "%s\n", query_error);
+                return 1;
+            }
+            opt.where = &where;
+        } else if (strcmp(argv[argi], "-i") == 0) opt.build_index = 1;
+        else if (strcmp(argv[argi], "-s") == 0 && argi + 1 < argc) opt.search = argv[++argi];
+        else if (strcmp(argv[argi], "-a") == 0) opt.approx = 1;
+        else if (strcmp(argv[argi], "-T") == 0) opt.templates = 1;
+        else if (strcmp(argv[argi], "-R") == 0) opt.raw = 1;
+        else if (strcmp(argv[argi], "-m") == 0 && argi + 1 < argc) {
+            opt.access = parse_access(argv[++argi]);
+            opt.input_stats = 1;
+            if (opt.access == -1) usage();
+        }
+        else if (strcmp(argv[argi], "-u") == 0 && argi + 1 < argc) opt.sketch.hll_error = atof(argv[++argi]);
+        else if (strcmp(argv[argi], "-e") == 0 && argi + 1 < argc) opt.sketch.cm_error = atof(argv[++argi]);
+        else if (strcmp(argv[argi], "-d") == 0 && argi + 1 < argc) opt.sketch.cm_delta = atof(argv[++argi]);
+        else if (strcmp(argv[argi], "-k") == 0 && argi + 1 < argc) opt.sketch.top = atoi(argv[++argi]);
+        else if (strcmp(argv[argi], "-t") == 0 && argi + 1 < argc) threads = atoi(argv[++argi]);
+        else usage();
+    }
+    if (opt.approx) {
+        sketch_params *p = &opt.sketch;
+        if (opt.count_only || opt.build_index || opt.search || !(p->hll_error > 0 && p->hll_error < 1) ||
+            !(p->cm_error > 0 && p->cm_error < 1) || !(p->cm_delta > 0 && p->cm_delta < 1) || p->top < 1 ||
+            p->top > 1000)
+            usage();
+        opt.pool = pf_create(threads);
+        if (!opt.pool) {
+            fprintf(stderr, "Could not start the thread pool\n");
+            return 1;
+        }
+        opt.total = &total;
+    }
+    if ((opt.count_only && !opt.where && !opt.search) || (opt.build_index && opt.count_only) ||
+        (opt.search && (opt.where || opt.build_index || opt.input_stats)) ||
+        (opt.templates && (opt.count_only || opt.search || opt.approx)) ||
+        (opt.raw && (opt.where || opt.count_only || opt.build_index || opt.search || opt.approx)))
+        usage();
+    void (*run)(const char *, const run_options *) = opt.search ? search_log_index
+                                                    : opt.approx ? approx_log_file
+                                                    : opt.raw    ? mine_raw_file : process_log_file;
+    if (argi == argc) {
+        run(DEFAULT_LOG_FILE, &opt);
+    }
+    for (; argi < argc; argi++, files++) {
+        run(argv[argi], &opt);
+    }
+    if (opt.approx) {
+        if (files > 1 && total.rows + total.bad > 0) approx_print(&total, &opt.sketch, "all files");
+        approx_free(&total);
+        pf_destroy(opt.pool);
+    }
+    if (opt.where) query_free(opt.where);
     return 0;
 }
 
-//This function processes a CSV log file efficiently using memory mapping (mmap), 
-//parses each line to extract data (like Date, Time, etc.), counts the occurrences of 
+//This function processes a CSV log file efficiently using memory mapping (mmap),
+//parses each line to extract data (like Date, Time, etc.), counts the occurrences of
 //unique entries for those fields, and outputs the results. It uses memory-mapping to improve
-//performance when handling large files, avoiding the need to load the entire file into memory 
-//at once.
\ No newline at end of file
+//performance when handling large files, avoiding the need to load the entire file into memory
+//at once.
@@ -0,0 +1,404 @@
+/*
+ * Parent/child IPC benchmark: latency and throughput per transport.
+ *
+ * hw1.c and part3_pipe_dup2() in lab2.c move data between a parent and a
+ * child over a pipe. This program measures what that costs next to the
+ * other ways two processes on one machine can talk:
+ *   pipe         pipe() with the default kernel buffer (64KB on Linux)
+ *   pipe-big     pipe() enlarged with F_SETPIPE_SZ (up to 1MB)
+ *   unix         socketpair(AF_UNIX, SOCK_STREAM)
+ *   eventfd-shm  slots in shared memory, handed over with two eventfds
+ *                (one counts filled slots, one free slots)
+ *   shm-ring     the lock-free ring in shm_ring.h
+ * For every transport and message size it forks a child and runs:
+ *   - latency: the parent sends a message and waits for the child to send
+ *     it back; the median and 99th percentile round trip are reported,
+ *   - throughput: the parent streams messages and the child reads them all
+ *     and answers with one byte; the time covers everything up to the
+ *     answer. Every message carries its sequence number in its first 8
+ *     bytes and the child checks them, so lost or reordered data shows up.
+ *
+ * Usage: ./ipc_bench [-t transport] [-s sizes] [-n round_trips] [-b MB_per_run]
+ *   -t  one of the names above (default: all)
+ *   -s  comma-separated message sizes in bytes (default 64,512,4096,65536,1048576)
+ *   -n  round trips per latency run (default 10000; fewer for large messages
+ *       so no run moves more than -b MB)
+ *   -b  megabytes streamed per throughput run (default 256)
+ * Build: gcc -O2 -pthread ipc_bench.c -o ipc_bench
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "shm_ring.h"
+
+#define DEFAULT_ROUND_TRIPS 10000
+#define DEFAULT_RUN_MB      256
+#define MIN_ROUND_TRIPS     100
+#define WARMUP_ROUND_TRIPS  100
+#define BIG_PIPE_BYTES      (1024 * 1024)
+#define RING_BYTES          (1024 * 1024)
+#define SLOT_BYTES          (64 * 1024)   // eventfd-shm: 16 slots of 64KB = 1MB, like the others
+#define SLOT_COUNT          16
+#define MAX_SIZES           32
+
+enum transport_kind { T_PIPE, T_PIPE_BIG, T_UNIX, T_EVENTFD_SHM, T_SHM_RING, NUM_TRANSPORTS };
+
+static const char *transport_names[NUM_TRANSPORTS] = { "pipe", "pipe-big", "unix", "eventfd-shm", "shm-ring" };
+
+// One direction of traffic. Set up before fork(); afterwards each process
+// keeps only its own end (chan_keep)
+typedef struct {
+    int kind;
+    int fd[2];                // pipe, unix: [0] receiving end, [1] sending end
+    int filled, free;         // eventfd-shm: semaphore eventfds
+    unsigned char *slots;     // eventfd-shm: SLOT_COUNT * SLOT_BYTES of shared memory
+    unsigned next;            // eventfd-shm: next slot this end uses
+    shm_ring ring;
+    int sender;               // set by chan_keep: this process writes (1) or reads (0)
+} channel;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* -------------------------------------------
+   Channels
+   ------------------------------------------- */
+
+// Returns the pipe buffer size actually set, or -1
+static int grow_pipe(int fd, int want) {
+    for (int size = want; size >= 4096; size /= 2)
+        if (fcntl(fd, F_SETPIPE_SZ, size) != -1) return fcntl(fd, F_GETPIPE_SZ);
+    return -1;
+}
+
+static int chan_open(channel *c, int kind) {
+    memset(c, 0, sizeof(*c));
+    c->kind = kind;
+    c->fd[0] = c->fd[1] = c->filled = c->free = -1;
+    switch (kind) {
+    case T_PIPE:
+        return pipe(c->fd);
+    case T_PIPE_BIG:
+        if (pipe(c->fd) == -1) return -1;
+        return grow_pipe(c->fd[1], BIG_PIPE_BYTES) == -1 ? -1 : 0;
+    case T_UNIX:
+        return socketpair(AF_UNIX, SOCK_STREAM, 0, c->fd);
+    case T_EVENTFD_SHM:
+        c->slots = mmap(NULL, (size_t)SLOT_COUNT * SLOT_BYTES, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (c->slots == MAP_FAILED) {
+            c->slots = NULL;
+            return -1;
+        }
+        c->filled = eventfd(0, EFD_SEMAPHORE);
+        c->free = eventfd(SLOT_COUNT, EFD_SEMAPHORE);
+        return c->filled == -1 || c->free == -1 ? -1 : 0;
+    case T_SHM_RING:
+        return shm_ring_create(&c->ring, RING_BYTES);
+    }
+    return -1;
+}
+
+// Drop the end this process does not use
+static void chan_keep(channel *c, int sender) {
+    c->sender = sender;
+    if (c->kind == T_PIPE || c->kind == T_PIPE_BIG || c->kind == T_UNIX) {
+        close(c->fd[!sender]);
+        c->fd[!sender] = -1;
+    }
+}
+
+// Like closing a pipe end, this lets a peer blocked on the channel see
+// end of data (reader) or EPIPE (writer) instead of waiting forever
+static void chan_close(channel *c) {
+    for (int i = 0; i < 2; i++)
+        if (c->fd[i] != -1) close(c->fd[i]);
+    if (c->filled != -1) close(c->filled);
+    if (c->free != -1) close(c->free);
+    if (c->slots) munmap(c->slots, (size_t)SLOT_COUNT * SLOT_BYTES);
+    if (c->kind == T_SHM_RING && c->ring.h) {
+        if (c->sender) shm_ring_close_writer(&c->ring);
+        else shm_ring_close_reader(&c->ring);
+        shm_ring_destroy(&c->ring);
+    }
+}
+
+static int fd_write_all(int fd, const unsigned char *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int fd_read_all(int fd, unsigned char *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int eventfd_take(int fd) {
+    uint64_t v;
+    return fd_read_all(fd, (unsigned char *)&v, sizeof(v));
+}
+
+static int eventfd_give(int fd) {
+    uint64_t v = 1;
+    return fd_write_all(fd, (unsigned char *)&v, sizeof(v));
+}
+
+// Sends all len bytes; -1 on error
+static int chan_send(channel *c, const unsigned char *p, size_t len) {
+    switch (c->kind) {
+    case T_PIPE:
+    case T_PIPE_BIG:
+    case T_UNIX:
+        return fd_write_all(c->fd[1], p, len);
+    case T_EVENTFD_SHM:
+        // Both ends cut a message into the same slot-sized pieces
+        while (len > 0) {
+            size_t n = len < SLOT_BYTES ? len : SLOT_BYTES;
+            if (eventfd_take(c->free) == -1) return -1;
+            memcpy(c->slots + (size_t)c->next * SLOT_BYTES, p, n);
+            c->next = (c->next + 1) % SLOT_COUNT;
+            if (eventfd_give(c->filled) == -1) return -1;
+            p += n;
+            len -= n;
+        }
+        return 0;
+    case T_SHM_RING:
+        return shm_ring_write(&c->ring, p, len) == (ssize_t)len ? 0 : -1;
+    }
+    return -1;
+}
+
+// Receives exactly len bytes; -1 on error or end of data
+static int chan_recv(channel *c, unsigned char *p, size_t len) {
+    switch (c->kind) {
+    case T_PIPE:
+    case T_PIPE_BIG:
+    case T_UNIX:
+        return fd_read_all(c->fd[0], p, len);
+    case T_EVENTFD_SHM:
+        while (len > 0) {
+            size_t n = len < SLOT_BYTES ? len : SLOT_BYTES;
+            if (eventfd_take(c->filled) == -1) return -1;
+            memcpy(p, c->slots + (size_t)c->next * SLOT_BYTES, n);
+            c->next = (c->next + 1) % SLOT_COUNT;
+            if (eventfd_give(c->free) == -1) return -1;
+            p += n;
+            len -= n;
+        }
+        return 0;
+    case T_SHM_RING:
+        while (len > 0) {
+            ssize_t n = shm_ring_read(&c->ring, p, len);
+            if (n <= 0) return -1;
+            p += n;
+            len -= n;
+        }
+        return 0;
+    }
+    return -1;
+}
+
+/* -------------------------------------------
+   Benchmark
+   ------------------------------------------- */
+
+typedef struct {
+    double rtt_p50, rtt_p99;   // seconds
+    double seconds;            // throughput run
+    uint64_t bytes, messages;
+} bench_result;
+
+static void stamp(unsigned char *buf, size_t size, uint64_t seq) {
+    if (size >= sizeof(seq)) memcpy(buf, &seq, sizeof(seq));
+}
+
+static int stamped(const unsigned char *buf, size_t size, uint64_t seq) {
+    uint64_t got;
+    if (size < sizeof(got)) return 1;
+    memcpy(&got, buf, sizeof(got));
+    return got == seq;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Child side: echo the round trips, then drain the stream and report
+static int child_run(channel *down, channel *up, unsigned char *buf, size_t size, uint64_t trips,
+                     uint64_t messages) {
+    for (uint64_t i = 0; i < trips; i++)
+        if (chan_recv(down, buf, size) == -1 || chan_send(up, buf, size) == -1) return 1;
+    unsigned char status = 'k';
+    for (uint64_t i = 0; i < messages; i++) {
+        if (chan_recv(down, buf, size) == -1) return 1;
+        if (!stamped(buf, size, i)) status = 'x';
+    }
+    return chan_send(up, &status, 1) == -1;
+}
+
+static int parent_run(channel *down, channel *up, unsigned char *buf, size_t size, uint64_t trips,
+                      uint64_t messages, double *rtt, bench_result *res) {
+    for (uint64_t i = 0; i < trips; i++) {
+        stamp(buf, size, i);
+        double t0 = now_seconds();
+        if (chan_send(down, buf, size) == -1 || chan_recv(up, buf, size) == -1) return -1;
+        if (i >= WARMUP_ROUND_TRIPS) rtt[i - WARMUP_ROUND_TRIPS] = now_seconds() - t0;
+        if (!stamped(buf, size, i)) return -1;
+    }
+    uint64_t timed = trips - WARMUP_ROUND_TRIPS;
+    qsort(rtt, timed, sizeof(double), cmp_double);
+    res->rtt_p50 = rtt[timed / 2];
+    res->rtt_p99 = rtt[timed * 99 / 100];
+
+    unsigned char status = 0;
+    double t0 = now_seconds();
+    for (uint64_t i = 0; i < messages; i++) {
+        stamp(buf, size, i);
+        if (chan_send(down, buf, size) == -1) return -1;
+    }
+    if (chan_recv(up, &status, 1) == -1) return -1;
+    res->seconds = now_seconds() - t0;
+    res->messages = messages;
+    res->bytes = messages * size;
+    return status == 'k' ? 0 : -1;
+}
+
+static int bench(int kind, size_t size, uint64_t round_trips, uint64_t run_bytes, bench_result *res) {
+    uint64_t trips = run_bytes / size < round_trips ? run_bytes / size : round_trips;
+    if (trips < MIN_ROUND_TRIPS) trips = MIN_ROUND_TRIPS;
+    trips += WARMUP_ROUND_TRIPS;
+    uint64_t messages = run_bytes / size ? run_bytes / size : 1;
+
+    channel down, up;   // parent -> child, child -> parent
+    if (chan_open(&down, kind) == -1 || chan_open(&up, kind) == -1) {
+        perror(transport_names[kind]);
+        exit(EXIT_FAILURE);
+    }
+    unsigned char *buf = malloc(size);
+    double *rtt = malloc(trips * sizeof(double));
+    if (!buf || !rtt) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    memset(buf, 0x5a, size);
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (pid == 0) {
+        chan_keep(&down, 0);
+        chan_keep(&up, 1);
+        int child_rc = child_run(&down, &up, buf, size, trips, messages);
+        chan_close(&down);
+        chan_close(&up);
+        _exit(child_rc);
+    }
+    chan_keep(&down, 1);
+    chan_keep(&up, 0);
+    int rc = parent_run(&down, &up, buf, size, trips, messages, rtt, res);
+    chan_close(&down);
+    chan_close(&up);
+    // eventfd-shm has no end-of-data signal: both processes hold both eventfds
+    if (rc == -1) kill(pid, SIGKILL);
+
+    int wstatus;
+    if (waitpid(pid, &wstatus, 0) == -1 || !WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) rc = -1;
+    free(buf);
+    free(rtt);
+    return rc;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: ./ipc_bench [-t transport] [-s sizes] [-n round_trips] [-b MB_per_run]\nTransports:");
+    for (int i = 0; i < NUM_TRANSPORTS; i++) fprintf(stderr, " %s", transport_names[i]);
+    fprintf(stderr, "\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+    size_t sizes[MAX_SIZES] = { 64, 512, 4096, 65536, 1048576 };
+    int num_sizes = 5;
+    uint64_t round_trips = DEFAULT_ROUND_TRIPS, run_bytes = (uint64_t)DEFAULT_RUN_MB * 1024 * 1024;
+    const char *only = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:s:n:b:")) != -1) {
+        switch (opt) {
+        case 't': only = optarg; break;
+        case 's': {
+            char *p = optarg;
+            for (num_sizes = 0; *p && num_sizes < MAX_SIZES; num_sizes++) {
+                sizes[num_sizes] = strtoull(p, &p, 10);
+                if (sizes[num_sizes] == 0 || (*p && *p++ != ',')) usage();
+            }
+            if (*p) usage();
+            break;
+        }
+        case 'n': round_trips = strtoull(optarg, NULL, 10); break;
+        case 'b': run_bytes = strtoull(optarg, NULL, 10) * 1024 * 1024; break;
+        default: usage();
+        }
+    }
+    if (optind != argc || num_sizes == 0 || round_trips == 0 || run_bytes == 0) usage();
+    int found = only == NULL;
+    for (int k = 0; k < NUM_TRANSPORTS; k++) found |= only && strcmp(only, transport_names[k]) == 0;
+    if (!found) usage();
+
+    int probe[2], default_pipe = 0, big_pipe = 0;
+    if (pipe(probe) == 0) {
+        default_pipe = fcntl(probe[1], F_GETPIPE_SZ);
+        big_pipe = grow_pipe(probe[1], BIG_PIPE_BYTES);
+        close(probe[0]);
+        close(probe[1]);
+    }
+    printf("Pipe buffer %d KB (pipe-big %d KB), shm-ring %d KB, eventfd-shm %d x %d KB slots\n\n",
+           default_pipe / 1024, big_pipe / 1024, RING_BYTES / 1024, SLOT_COUNT, SLOT_BYTES / 1024);
+    printf("%-11s | %10s | %13s | %13s | %12s | %12s\n", "Transport", "Size (B)", "RTT p50 (us)",
+           "RTT p99 (us)", "Thru (MB/s)", "Msgs/s");
+
+    for (int k = 0; k < NUM_TRANSPORTS; k++) {
+        if (only && strcmp(only, transport_names[k]) != 0) continue;
+        for (int s = 0; s < num_sizes; s++) {
+            bench_result r;
+            if (bench(k, sizes[s], round_trips, run_bytes, &r) == -1) {
+                fprintf(stderr, "%s: run with %zu-byte messages failed or lost data\n", transport_names[k],
+                        sizes[s]);
+                return 1;
+            }
+            printf("%-11s | %10zu | %13.2f | %13.2f | %12.1f | %12.0f\n", transport_names[k], sizes[s],
+                   r.rtt_p50 * 1e6, r.rtt_p99 * 1e6, r.bytes / r.seconds / (1024 * 1024), r.messages / r.seconds);
+        }
+    }
+    return 0;
+}
@@ -12,66 +12,62 @@
  */
  
  #include <stdio.h>
+ #include <inttypes.h>  // SCNd64/PRId64 for the 64-bit columns
+ #include "proc_table.h"  // pid/burst/... columns, 64-bit waiting-time scan
  int main()
  {
-     int pid[15];
-     int bt[15];
      int n;
      //Takes in the number of process from the user
      printf("Enter the number of processes: ");
-     scanf("%d",&n);
-     
+     if (scanf("%d",&n) != 1 || n <= 0) return 1;
+
+     //One column per attribute, sized for n (no fixed 15-process limit)
+     proc_table t;
+     if (pt_alloc(&t, n) == -1)
+     {
+         printf("Not enough memory for %d processes\n", n);
+         return 1;
+     }
+
      //Takes in the process id from the end users
      printf("Enter process id of all the processes: ");
      for(int i=0;i<n;i++)
      {
-         scanf("%d",&pid[i]);
+         scanf("%" SCNd64,&t.pid[i]);
      }
-    
+
      //Takes in the burst times of all the processes
      printf("Enter burst time of all the processes: ");
      for(int i=0;i<n;i++)
      {
-         scanf("%d",&bt[i]);
-     }
-  
-     int i, wt[n];
-     wt[0]=0; //Initial wait time is 0 for the first process
-  
-     //for calculating waiting time of each process
-     for(i=1; i<n; i++)
-     {
-         wt[i]= bt[i-1]+ wt[i-1];
+         scanf("%" SCNd64,&t.burst[i]);
      }
-  
+
+     //Everybody arrives at time 0, so the waiting time of each process is
+     //its start time: a prefix sum of the earlier bursts, which pt_schedule()
+     //computes block-wise (no pool = on this thread)
+     pt_schedule(&t, NULL);
+
      printf("Process ID     Burst Time     Waiting Time     TurnAround Time\n");
-     float twt=0.0; //total wait time
-     float tat= 0.0;  //total turn around time
-     for(i=0; i<n; i++)
+     for(int i=0; i<n; i++)
      {
-         printf("%d\t\t", pid[i]);
-         printf("%d\t\t", bt[i]);
-         printf("%d\t\t", wt[i]);
-  
-         //calculating and printing turnaround time of each process
-         printf("%d\t\t", bt[i]+wt[i]);
+         printf("%" PRId64 "\t\t", t.pid[i]);
+         printf("%" PRId64 "\t\t", t.burst[i]);
+         printf("%" PRId64 "\t\t", t.start[i] - t.arrival[i]);
+
+         //turnaround time of each process
+         printf("%" PRId64 "\t\t", t.finish[i] - t.arrival[i]);
          printf("\n");
-  
-         //for calculating total waiting time
-         twt += wt[i];
-  
-         //for calculating total turnaround time
-         tat += (wt[i]+bt[i]);
      }
-     float att,awt;
-  
-     //for calculating average waiting time
-     awt = twt/n; //divide by the number of processes
-  
-     //for calculating average turnaround time
-     att = tat/n;
-     printf("Avg. waiting time= %f\n",awt);
-     printf("Avg. turnaround time= %f",att);
+
+     //total waiting and turnaround time as exact 64-bit sums (a float
+     //total stops counting single units past 2^24)
+     proc_metrics m = pt_metrics(&t, NULL);
+
+     //averages: divide by the number of processes
+     printf("Avg. waiting time= %f\n",(double)m.total_wait/n);
+     printf("Avg. turnaround time= %f",(double)m.total_turnaround/n);
+     pt_free(&t);
  }
 
 
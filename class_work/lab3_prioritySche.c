@@ -8,68 +8,51 @@
 //scheduling is done on FCFS basis (first come first serve). Priority Scheduling is of two types: 
 //Preemptive and Non-Preemptive.
 #include <stdio.h>
- 
-//Function to swap two variables
-void swap(int *a,int *b)
-{
-    int temp=*a;
-    *a=*b;
-    *b=temp;
-}
+#include <inttypes.h>   // SCNd64/PRId64 for the 64-bit columns
+#include "proc_table.h" // pid/burst/priority columns, radix sort, 64-bit scan
+
 int main()
 {
     int n;
     printf("Enter Number of Processes: ");
-    scanf("%d",&n);
- 
-    // b is array for burst time, p for priority and index for process id
-    int b[n],p[n],index[n];
-    for(int i=0;i<n;i++)
+    if (scanf("%d",&n) != 1 || n <= 0)
+        return 1;
+
+    // one column each for burst time, priority and process id
+    proc_table t;
+    if (pt_alloc(&t, n) == -1)
     {
-        printf("Enter Burst Time and Priority Value for Process %d: ",i+1);
-        scanf("%d %d",&b[i],&p[i]);
-        index[i]=i+1;
+        printf("Not enough memory for %d processes\n", n);
+        return 1;
     }
     for(int i=0;i<n;i++)
-    { 
-      //The current process and its current position
-        int a=p[i],m=i;
- 
-        //Finding out highest priority element and placing it at its desired position
-        for(int j=i;j<n;j++)
-        {
-            //Used to keep track of the highest priority 
-            //Selection Sort
-            if(p[j] > a) 
-            {
-                a=p[j];
-                m=j;
-            }
-        }
- 
-        //Swapping processes
-        swap(&p[i], &p[m]);
-        swap(&b[i], &b[m]);
-        swap(&index[i],&index[m]);
+    {
+        printf("Enter Burst Time and Priority Value for Process %d: ",i+1);
+        scanf("%" SCNd64 " %" SCNd64,&t.burst[i],&t.priority[i]);
+        t.pid[i]=i+1;
     }
- 
-    // T stores the starting time of process
-    int t=0;
- 
+
+    //Finding out highest priority element and placing it at its desired position:
+    //a stable radix sort on priority, highest value first; equal priorities
+    //stay in input order, which is the FCFS tie-break described above
+    pt_sort(&t, t.priority, 1);
+
+    // start and finish of every process when they run in this order
+    pt_schedule(&t, NULL);
+
     //Printing scheduled process
     printf("Order of process Execution is\n");
     for(int i=0;i<n;i++)
     {
-        printf("P%d is executed from %d to %d\n",index[i],t,t+b[i]);
-        t+=b[i];
+        printf("P%" PRId64 " is executed from %" PRId64 " to %" PRId64 "\n",t.pid[i],t.start[i],t.finish[i]);
     }
     printf("\n");
     printf("Process Id     Burst Time   Wait Time    TurnAround Time\n");
-    int wait_time=0;
     for(int i=0;i<n;i++)
     {
-        printf("P%d          %d          %d          %d\n",index[i],b[i],wait_time,wait_time + b[i]);
-        wait_time += b[i];
+        printf("P%" PRId64 "          %" PRId64 "          %" PRId64 "          %" PRId64 "\n",t.pid[i],t.burst[i],
+               t.start[i]-t.arrival[i],t.finish[i]-t.arrival[i]);
     }
+    pt_free(&t);
     return 0;
 }
@@ -5,73 +5,54 @@
 // average WT, and prints a Gantt chart
 
 #include<stdio.h>
+#include<inttypes.h>   // SCNd64/PRId64 for the 64-bit columns
+#include "proc_table.h" // pid/burst/... columns, radix sort, 64-bit waiting-time scan
 int main()
 {
-    int bt[20],p[20],wt[20],tat[20],i,j,n,total=0,totalT=0,pos,temp;
-    float avg_wt,avg_tat;
+    int i,n;
     printf("Enter number of process:");
-    scanf("%d",&n);
- 
+    if(scanf("%d",&n)!=1 || n<=0)
+        return 1;
+
+    //one column per attribute, sized for n (no fixed 20-process limit)
+    proc_table t;
+    if(pt_alloc(&t,n)==-1)
+    {
+        printf("Not enough memory for %d processes\n",n);
+        return 1;
+    }
+
     printf("\nEnter Burst Time:\n");
     for(i=0;i<n;i++)
     {
         printf("p%d:",i+1);
-        scanf("%d",&bt[i]);
-        p[i]=i+1;
+        scanf("%" SCNd64,&t.burst[i]);
+        t.pid[i]=i+1;
     }
- 
+
     //sorting of burst times
-    //sort the processes based on their burst time
-    for(i=0;i<n;i++) //loops through all burst times
-    {
-        pos=i;
-        for(j=i+1;j<n;j++) //compares each process's burst time with the others
-        {
-            if(bt[j]<bt[pos])
-                pos=j;
-        }
- 
-        temp=bt[i];
-        bt[i]=bt[pos];
-        bt[pos]=temp;
- 
-        temp=p[i];
-        p[i]=p[pos];
-        p[pos]=temp;
-    }
- 
-    wt[0]=0;
- 
+    //sort the processes based on their burst time (stable radix sort instead
+    //of a selection sort: equal bursts keep their input order)
+    pt_sort(&t,t.burst,0);
+
     //finding the waiting time of all the processes
-    //used to reorder the processes based on their burst times in ascending order
-    //outer loop - iterates through all processes 
-    for(i=1;i<n;i++)
-    {
-        wt[i]=0;
-        for(j=0;j<i;j++) //
-             //individual WT by adding BT of all previous completed processes
-            wt[i]+=bt[j];
- 
-        //total waiting time
-        total+=wt[i];   
-    }
- 
-    //average waiting time
-    avg_wt=(float)total/n;  
- 
+    //the waiting time of a process is the sum of the bursts before it; one
+    //prefix sum gives all of them instead of re-adding them for every process
+    pt_schedule(&t,NULL);
+
+    //total waiting and turnaround time as exact 64-bit sums
+    proc_metrics m=pt_metrics(&t,NULL);
+
     printf("\nProcess\t Burst Time \tWaiting Time\tTurnaround Time");
     for(i=0;i<n;i++)
     {
         //turnaround time of individual processes
-        tat[i]=bt[i]+wt[i]; 
- 
-        //total turnaround time
-        totalT+=tat[i];      
-        printf("\np%d\t\t %d\t\t %d\t\t\t%d",p[i],bt[i],wt[i],tat[i]);
+        printf("\np%" PRId64 "\t\t %" PRId64 "\t\t %" PRId64 "\t\t\t%" PRId64,t.pid[i],t.burst[i],
+               t.start[i]-t.arrival[i],t.finish[i]-t.arrival[i]);
     }
- 
-    //average turnaround time
-    avg_tat=(float)totalT/n;     
-    printf("\n\nAverage Waiting Time=%f",avg_wt);
-    printf("\nAverage Turnaround Time=%f",avg_tat);
+
+    //average waiting and turnaround time
+    printf("\n\nAverage Waiting Time=%f",(double)m.total_wait/n);
+    printf("\nAverage Turnaround Time=%f",(double)m.total_turnaround/n);
+    pt_free(&t);
 }
@@ -0,0 +1,344 @@
+/*
+ * Memory fill/copy bandwidth benchmark.
+ *
+ * part4_advanced() in lab2.c times one memset() against a byte loop over 1MB
+ * with clock(). 1MB sits in cache and clock() measures CPU time with coarse
+ * resolution, so the numbers say little about the memory subsystem. This
+ * program measures it properly:
+ *   - buffer sizes sweep from L1-sized (16KB) up to a configurable maximum,
+ *   - fill kernels: memset, byte loop, 64-bit stores, AVX2 stores,
+ *     non-temporal (streaming) stores and "rep stosb",
+ *   - copy kernels: memcpy and non-temporal copy,
+ *   - 1..N threads, each pinned to its own CPU and working on its own slice,
+ *   - transparent hugepages requested or refused with madvise(),
+ *   - wall-clock time from clock_gettime(CLOCK_MONOTONIC), best of several
+ *     trials, reported in GB/s (10^9 bytes per second).
+ *
+ * Usage: ./mem_bandwidth [-t threads] [-m max_size_MB] [-r trials] [-H on|off] [-k kernel]
+ * Build: gcc -O2 -mavx2 -pthread mem_bandwidth.c -o mem_bandwidth
+ *        (without -mavx2 the AVX2 and streaming kernels fall back to SSE2)
+ */
+#define _GNU_SOURCE  // sched_setaffinity(), CPU_SET
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define MIN_SIZE        (16 * 1024)              // smallest buffer (fits in L1)
+#define DEFAULT_MAX_MB  1024                     // largest buffer by default (1GB)
+#define TARGET_BYTES    (512ULL * 1024 * 1024)   // bytes touched per timed trial
+#define DEFAULT_TRIALS  5
+#define FILL_BYTE       'A'
+
+typedef void (*kernel_fn)(char *dst, const char *src, size_t len);
+
+typedef struct {
+    const char *name;
+    kernel_fn fn;
+    int is_copy;  // copy kernels move len bytes, counted as 2*len of traffic
+} kernel_t;
+
+/* -------------------------------------------
+   Kernels
+   ------------------------------------------- */
+
+static void k_memset(char *dst, const char *src, size_t len) {
+    (void)src;
+    memset(dst, FILL_BYTE, len);
+}
+
+// Same as the manual loop in part4_advanced(); volatile keeps the compiler
+// from turning it back into memset()
+static void k_byte_loop(char *dst, const char *src, size_t len) {
+    (void)src;
+    volatile char *p = dst;
+    for (size_t i = 0; i < len; i++) p[i] = FILL_BYTE;
+}
+
+static void k_store64(char *dst, const char *src, size_t len) {
+    (void)src;
+    uint64_t v = 0x0101010101010101ULL * (unsigned char)FILL_BYTE;
+    volatile uint64_t *p = (volatile uint64_t *)dst;
+    for (size_t i = 0; i < len / 8; i++) p[i] = v;
+}
+
+#if defined(__AVX2__)
+static void k_vector(char *dst, const char *src, size_t len) {
+    (void)src;
+    __m256i v = _mm256_set1_epi8(FILL_BYTE);
+    for (size_t i = 0; i + 32 <= len; i += 32) _mm256_store_si256((__m256i *)(dst + i), v);
+}
+
+// Non-temporal stores bypass the cache, so large fills do not read the
+// destination lines first (no read-for-ownership)
+static void k_stream(char *dst, const char *src, size_t len) {
+    (void)src;
+    __m256i v = _mm256_set1_epi8(FILL_BYTE);
+    for (size_t i = 0; i + 32 <= len; i += 32) _mm256_stream_si256((__m256i *)(dst + i), v);
+    _mm_sfence();
+}
+
+static void k_stream_copy(char *dst, const char *src, size_t len) {
+    for (size_t i = 0; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_load_si256((const __m256i *)(src + i));
+        _mm256_stream_si256((__m256i *)(dst + i), v);
+    }
+    _mm_sfence();
+}
+#define VECTOR_NAME "avx2"
+#elif defined(__SSE2__)
+static void k_vector(char *dst, const char *src, size_t len) {
+    (void)src;
+    __m128i v = _mm_set1_epi8(FILL_BYTE);
+    for (size_t i = 0; i + 16 <= len; i += 16) _mm_store_si128((__m128i *)(dst + i), v);
+}
+
+static void k_stream(char *dst, const char *src, size_t len) {
+    (void)src;
+    __m128i v = _mm_set1_epi8(FILL_BYTE);
+    for (size_t i = 0; i + 16 <= len; i += 16) _mm_stream_si128((__m128i *)(dst + i), v);
+    _mm_sfence();
+}
+
+static void k_stream_copy(char *dst, const char *src, size_t len) {
+    for (size_t i = 0; i + 16 <= len; i += 16) {
+        __m128i v = _mm_load_si128((const __m128i *)(src + i));
+        _mm_stream_si128((__m128i *)(dst + i), v);
+    }
+    _mm_sfence();
+}
+#define VECTOR_NAME "sse2"
+#endif
+
+#if defined(__x86_64__)
+static void k_rep_stosb(char *dst, const char *src, size_t len) {
+    (void)src;
+    void *d = dst;
+    size_t n = len;
+    __asm__ volatile("rep stosb" : "+D"(d), "+c"(n) : "a"(FILL_BYTE) : "memory");
+}
+#endif
+
+static void k_memcpy(char *dst, const char *src, size_t len) {
+    memcpy(dst, src, len);
+}
+
+static const kernel_t kernels[] = {
+    { "memset",      k_memset,      0 },
+    { "byte_loop",   k_byte_loop,   0 },
+    { "store64",     k_store64,     0 },
+#ifdef VECTOR_NAME
+    { VECTOR_NAME,   k_vector,      0 },
+    { "nt_store",    k_stream,      0 },
+#endif
+#if defined(__x86_64__)
+    { "rep_stosb",   k_rep_stosb,   0 },
+#endif
+    { "memcpy",      k_memcpy,      1 },
+#ifdef VECTOR_NAME
+    { "nt_copy",     k_stream_copy, 1 },
+#endif
+};
+#define NUM_KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+/* -------------------------------------------
+   Threads
+   All threads wait on a barrier, run the kernel over their own slice of the
+   buffer, and wait again; the main thread times the span between barriers.
+   ------------------------------------------- */
+
+typedef struct {
+    int id;
+    int cpu;              // CPU to pin to, -1 for none
+    char *dst;
+    const char *src;
+    size_t len;           // slice length
+    size_t reps;          // kernel calls per trial
+    const kernel_t *kernel;
+    pthread_barrier_t *start, *done;
+    volatile int *quit;
+} worker_t;
+
+static void *worker(void *arg) {
+    worker_t *w = arg;
+    if (w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(w->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    for (;;) {
+        pthread_barrier_wait(w->start);
+        if (*w->quit) break;
+        for (size_t r = 0; r < w->reps; r++) w->kernel->fn(w->dst, w->src, w->len);
+        pthread_barrier_wait(w->done);
+    }
+    return NULL;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Allocate a 2MB-aligned buffer and ask for (or refuse) transparent hugepages
+static char *alloc_buffer(size_t size, int hugepages) {
+    size_t align = 2 * 1024 * 1024;
+    size_t rounded = (size + align - 1) / align * align;
+    void *p = mmap(NULL, rounded + align, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        perror("Error allocating benchmark buffer");
+        exit(EXIT_FAILURE);
+    }
+    char *aligned = (char *)(((uintptr_t)p + align - 1) & ~(uintptr_t)(align - 1));
+    // Trim the slack so free_buffer() can unmap exactly [aligned, aligned + rounded)
+    if (aligned > (char *)p) munmap(p, aligned - (char *)p);
+    munmap(aligned + rounded, (char *)p + rounded + align - (aligned + rounded));
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, rounded, hugepages ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+#endif
+    memset(aligned, 0, rounded);  // fault every page in before timing
+    return aligned;
+}
+
+static void free_buffer(char *p, size_t size) {
+    size_t align = 2 * 1024 * 1024;
+    munmap(p, (size + align - 1) / align * align);
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: ./mem_bandwidth [-t threads] [-m max_size_MB] [-r trials] "
+                    "[-H on|off] [-k kernel]\nKernels:");
+    for (size_t i = 0; i < NUM_KERNELS; i++) fprintf(stderr, " %s", kernels[i].name);
+    fprintf(stderr, "\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+    int num_threads = 1, trials = DEFAULT_TRIALS, hugepages = 1;
+    size_t max_size = (size_t)DEFAULT_MAX_MB * 1024 * 1024;
+    const char *only = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:m:r:H:k:")) != -1) {
+        switch (opt) {
+        case 't': num_threads = atoi(optarg); break;
+        case 'm': max_size = strtoull(optarg, NULL, 10) * 1024 * 1024; break;
+        case 'r': trials = atoi(optarg); break;
+        case 'H': hugepages = strcmp(optarg, "off") != 0; break;
+        case 'k': only = optarg; break;
+        default:  usage();
+        }
+    }
+    if (num_threads < 1 || trials < 1 || max_size < MIN_SIZE) usage();
+    if (only) {
+        size_t k = 0;
+        while (k < NUM_KERNELS && strcmp(only, kernels[k].name) != 0) k++;
+        if (k == NUM_KERNELS) usage();
+    }
+
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("Threads: %d (thread i pinned to CPU i, %ld online), trials: %d, hugepages: %s\n",
+           num_threads, ncpu, trials, hugepages ? "on" : "off");
+
+    pthread_barrier_t start, done;
+    pthread_barrier_init(&start, NULL, num_threads + 1);
+    pthread_barrier_init(&done, NULL, num_threads + 1);
+    volatile int quit = 0;
+    worker_t *w = calloc(num_threads, sizeof(worker_t));
+    pthread_t *tid = calloc(num_threads, sizeof(pthread_t));
+    if (!w || !tid) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        w[i].id = i;
+        w[i].cpu = i < ncpu ? i : -1;
+        w[i].start = &start;
+        w[i].done = &done;
+        w[i].quit = &quit;
+        if (pthread_create(&tid[i], NULL, worker, &w[i]) != 0) {
+            fprintf(stderr, "Error creating thread %d\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    printf("\n%-10s", "size");
+    for (size_t k = 0; k < NUM_KERNELS; k++) {
+        if (!only || strcmp(only, kernels[k].name) == 0) printf(" %10s", kernels[k].name);
+    }
+    printf("   (GB/s, best of %d)\n", trials);
+
+    for (size_t size = MIN_SIZE; size <= max_size; size *= 2) {
+        if (size >= 1024 * 1024 * 1024) {
+            printf("%7zuGB ", size >> 30);
+        } else if (size >= 1024 * 1024) {
+            printf("%7zuMB ", size >> 20);
+        } else {
+            printf("%7zuKB ", size >> 10);
+        }
+
+        // Each thread gets an equal slice, rounded down to 64 bytes
+        size_t slice = size / num_threads / 64 * 64;
+        if (slice == 0) {
+            printf(" (too small for %d threads)\n", num_threads);
+            continue;
+        }
+        size_t reps = TARGET_BYTES / size;
+        if (reps == 0) reps = 1;
+
+        // Copy kernels need a source buffer as large as the destination.
+        // Fresh buffers per size, unmapped again below
+        char *dst = alloc_buffer(size, hugepages);
+        char *src = alloc_buffer(size, hugepages);
+        memset(src, 'S', size);
+
+        for (size_t k = 0; k < NUM_KERNELS; k++) {
+            if (only && strcmp(only, kernels[k].name) != 0) continue;
+            for (int i = 0; i < num_threads; i++) {
+                w[i].dst = dst + (size_t)i * slice;
+                w[i].src = src + (size_t)i * slice;
+                w[i].len = slice;
+                w[i].reps = reps;
+                w[i].kernel = &kernels[k];
+            }
+            double best = 0;
+            for (int t = 0; t < trials; t++) {
+                double t0 = now_seconds();
+                pthread_barrier_wait(&start);
+                pthread_barrier_wait(&done);
+                double elapsed = now_seconds() - t0;
+                double bytes = (double)slice * num_threads * reps * (kernels[k].is_copy ? 2 : 1);
+                double gbps = bytes / elapsed / 1e9;
+                if (gbps > best) best = gbps;
+            }
+            printf(" %10.2f", best);
+        }
+        printf("\n");
+        fflush(stdout);
+        free_buffer(dst, size);
+        free_buffer(src, size);
+    }
+
+    quit = 1;
+    pthread_barrier_wait(&start);
+    for (int i = 0; i < num_threads; i++) pthread_join(tid[i], NULL);
+    pthread_barrier_destroy(&start);
+    pthread_barrier_destroy(&done);
+    free(w);
+    free(tid);
+    return 0;
+}
@@ -0,0 +1,286 @@
+/*
+ * parallel_for.h - a small work-stealing parallel-for / reduce runtime.
+ *
+ * find_number_with_max_divisors() in os_hw_2.py (and the first version of
+ * divisors.c) split a range into equal static chunks. When the cost per
+ * item grows with n the last chunk finishes long after the others. Here:
+ *   - every worker owns a deque of index ranges; it works on the bottom
+ *     and idle workers steal from the top (the largest, oldest range),
+ *   - ranges are split lazily (lazy binary splitting): a worker only halves
+ *     its current range when its own deque is empty, i.e. when somebody may
+ *     be waiting for work, and otherwise runs `grain` iterations at a time,
+ *     so chunks adapt to the load without tuning a chunk size,
+ *   - pf_reduce() gives every worker its own cache-line aligned partial
+ *     result and combines them at the end, so the body never shares state.
+ * The calling thread takes part as worker 0; the others sleep on a
+ * condition variable between jobs.
+ *
+ * Interface:
+ *   pf_create()   start a pool (threads <= 0: one per online CPU)
+ *   pf_for()      run body over [begin, end)
+ *   pf_reduce()   same, with per-worker partial results combined into *result
+ *   pf_threads()  number of workers, to size per-worker scratch space
+ *   pf_destroy()  stop the threads and free the pool
+ * Bodies get (begin, end, worker, partial, arg); combine() must be
+ * associative and commutative because the ranges finish in any order.
+ *
+ * Header only: #include "parallel_for.h" and build with -pthread.
+ */
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PF_DEQUE_CAP 64   // lazy splitting keeps a deque nearly empty
+#define PF_CACHE_LINE 64
+
+typedef void (*pf_body)(uint64_t begin, uint64_t end, int worker, void *partial, void *arg);
+typedef void (*pf_init)(void *partial, void *arg);
+typedef void (*pf_combine)(void *into, const void *from, void *arg);
+
+typedef struct {
+    uint64_t begin, end;
+} pf_range;
+
+// A short critical section per push/pop/steal, so a spinlock beats a mutex
+typedef struct {
+    atomic_flag lock;
+    _Atomic unsigned top, bottom;  // thieves take items[top], the owner uses items[bottom - 1]
+    pf_range items[PF_DEQUE_CAP];
+} __attribute__((aligned(PF_CACHE_LINE))) pf_deque;
+
+typedef struct pf_pool {
+    int threads;
+    pthread_t *tid;
+    pf_deque *deques;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t start_cv, done_cv;
+    unsigned generation;  // bumped for every job
+    int busy;             // workers (besides the caller) still in the current job
+    int shutting_down;
+
+    // Current job
+    pf_body body;
+    void *arg;
+    uint64_t grain;
+    char *partials;
+    size_t partial_stride;
+    atomic_uint_fast64_t remaining;  // iterations not yet run
+} pf_pool;
+
+typedef struct {
+    pf_pool *pool;
+    int worker;
+} pf_worker_arg;
+
+static inline void pf_lock(pf_deque *d) {
+    while (atomic_flag_test_and_set_explicit(&d->lock, memory_order_acquire)) sched_yield();
+}
+
+static inline void pf_unlock(pf_deque *d) {
+    atomic_flag_clear_explicit(&d->lock, memory_order_release);
+}
+
+static inline int pf_push(pf_deque *d, pf_range r) {
+    pf_lock(d);
+    int ok = d->bottom - d->top < PF_DEQUE_CAP;
+    if (ok) d->items[d->bottom++ % PF_DEQUE_CAP] = r;
+    pf_unlock(d);
+    return ok;
+}
+
+static inline int pf_pop(pf_deque *d, pf_range *r) {
+    pf_lock(d);
+    int ok = d->bottom != d->top;
+    if (ok) *r = d->items[--d->bottom % PF_DEQUE_CAP];
+    pf_unlock(d);
+    return ok;
+}
+
+static inline int pf_steal_from(pf_deque *d, pf_range *r) {
+    if (d->bottom == d->top) return 0;  // racy peek, rechecked under the lock
+    pf_lock(d);
+    int ok = d->bottom != d->top;
+    if (ok) *r = d->items[d->top++ % PF_DEQUE_CAP];
+    pf_unlock(d);
+    return ok;
+}
+
+static inline int pf_deque_empty(pf_deque *d) {
+    return d->bottom == d->top;
+}
+
+// Try every other worker once, starting next to ourselves
+static inline int pf_steal(pf_pool *pool, int self, pf_range *r) {
+    for (int i = 1; i < pool->threads; i++) {
+        if (pf_steal_from(&pool->deques[(self + i) % pool->threads], r)) return 1;
+    }
+    return 0;
+}
+
+// Run one range, splitting it whenever our deque has run dry
+static inline void pf_run_range(pf_pool *pool, int w, pf_range r, void *partial) {
+    pf_deque *mine = &pool->deques[w];
+    while (r.end - r.begin > pool->grain) {
+        if (pf_deque_empty(mine)) {
+            uint64_t mid = r.begin + (r.end - r.begin) / 2;
+            if (pf_push(mine, (pf_range){ mid, r.end })) {
+                r.end = mid;
+                continue;
+            }
+        }
+        pool->body(r.begin, r.begin + pool->grain, w, partial, pool->arg);
+        atomic_fetch_sub_explicit(&pool->remaining, pool->grain, memory_order_acq_rel);
+        r.begin += pool->grain;
+    }
+    if (r.end > r.begin) {
+        pool->body(r.begin, r.end, w, partial, pool->arg);
+        atomic_fetch_sub_explicit(&pool->remaining, r.end - r.begin, memory_order_acq_rel);
+    }
+}
+
+static inline void pf_run_job(pf_pool *pool, int w) {
+    void *partial = pool->partials ? pool->partials + (size_t)w * pool->partial_stride : NULL;
+    pf_range r;
+    while (atomic_load_explicit(&pool->remaining, memory_order_acquire) != 0) {
+        if (pf_pop(&pool->deques[w], &r) || pf_steal(pool, w, &r)) pf_run_range(pool, w, r, partial);
+        else sched_yield();  // work is still running elsewhere; it may split soon
+    }
+}
+
+static inline void *pf_worker(void *p) {
+    pf_worker_arg *wa = p;
+    pf_pool *pool = wa->pool;
+    int w = wa->worker;
+    free(wa);
+
+    unsigned seen = 0;
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (pool->generation == seen && !pool->shutting_down) pthread_cond_wait(&pool->start_cv, &pool->mutex);
+        if (pool->shutting_down) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        pf_run_job(pool, w);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->busy == 0) pthread_cond_signal(&pool->done_cv);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+static inline int pf_threads(const pf_pool *pool) {
+    return pool->threads;
+}
+
+static inline void pf_destroy(pf_pool *pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutting_down = 1;
+    pthread_cond_broadcast(&pool->start_cv);
+    pthread_mutex_unlock(&pool->mutex);
+    for (int t = 1; t < pool->threads; t++) pthread_join(pool->tid[t], NULL);
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->start_cv);
+    pthread_cond_destroy(&pool->done_cv);
+    free(pool->tid);
+    free(pool->deques);
+    free(pool);
+}
+
+// Returns NULL if the pool cannot be started
+static inline pf_pool *pf_create(int threads) {
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    pf_pool *pool = calloc(1, sizeof(*pool));
+    if (!pool) return NULL;
+    pool->threads = threads;
+    pool->tid = calloc(threads, sizeof(pthread_t));
+    pool->deques = aligned_alloc(PF_CACHE_LINE, threads * sizeof(pf_deque));
+    if (!pool->tid || !pool->deques) {
+        free(pool->tid);
+        free(pool->deques);
+        free(pool);
+        return NULL;
+    }
+    memset(pool->deques, 0, threads * sizeof(pf_deque));
+    for (int t = 0; t < threads; t++) atomic_flag_clear(&pool->deques[t].lock);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->start_cv, NULL);
+    pthread_cond_init(&pool->done_cv, NULL);
+    atomic_init(&pool->remaining, 0);
+
+    for (int t = 1; t < threads; t++) {
+        pf_worker_arg *wa = malloc(sizeof(*wa));
+        if (wa) *wa = (pf_worker_arg){ pool, t };
+        if (!wa || pthread_create(&pool->tid[t], NULL, pf_worker, wa) != 0) {
+            free(wa);
+            pool->threads = t;  // only join the ones that started
+            pf_destroy(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+// grain: iterations run between checks for idle workers (0: pick one)
+static inline int pf_reduce(pf_pool *pool, uint64_t begin, uint64_t end, uint64_t grain, pf_body body, void *arg,
+                            size_t partial_size, pf_init init, pf_combine combine, void *result) {
+    if (end <= begin) return 0;
+    if (grain == 0) {
+        grain = (end - begin) / ((uint64_t)pool->threads * 256);
+        if (grain == 0) grain = 1;
+    }
+
+    size_t stride = (partial_size + PF_CACHE_LINE - 1) / PF_CACHE_LINE * PF_CACHE_LINE;
+    char *partials = NULL;
+    if (partial_size) {
+        partials = aligned_alloc(PF_CACHE_LINE, stride * pool->threads);
+        if (!partials) return -1;
+        for (int t = 0; t < pool->threads; t++) {
+            if (init) init(partials + (size_t)t * stride, arg);
+            else memset(partials + (size_t)t * stride, 0, partial_size);
+        }
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->body = body;
+    pool->arg = arg;
+    pool->grain = grain;
+    pool->partials = partials;
+    pool->partial_stride = stride;
+    atomic_store(&pool->remaining, end - begin);
+    pf_push(&pool->deques[0], (pf_range){ begin, end });
+    pool->busy = pool->threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start_cv);
+    pthread_mutex_unlock(&pool->mutex);
+
+    pf_run_job(pool, 0);
+
+    // Workers may still be leaving pf_run_job(); wait before touching partials
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->busy > 0) pthread_cond_wait(&pool->done_cv, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (partial_size) {
+        memcpy(result, partials, partial_size);
+        for (int t = 1; t < pool->threads; t++) combine(result, partials + (size_t)t * stride, arg);
+        free(partials);
+    }
+    return 0;
+}
+
+static inline int pf_for(pf_pool *pool, uint64_t begin, uint64_t end, uint64_t grain, pf_body body, void *arg) {
+    return pf_reduce(pool, begin, end, grain, body, arg, 0, NULL, NULL, NULL);
+}
+
+#endif
@@ -0,0 +1,536 @@
+/*
+ * Parallel fan-out/fan-in pipeline stage.
+ *
+ * hw1.c and part3_pipe_dup2() in lab2.c connect exactly one producer to one
+ * consumer over a single pipe, so a slow middle stage throttles everything.
+ * This program fans that middle stage out to K worker processes:
+ *   - the parent cuts its input into line-aligned chunks,
+ *   - chunk number i (its sequence number) goes to worker i % K (round-robin),
+ *   - every worker sends back its output tagged with the same sequence number,
+ *   - the parent puts the outputs back together in the original order.
+ *
+ * Usage: ./parallel_pipeline [-k workers] [-c chunk_bytes] filter [input_file]
+ *   filter is one of:
+ *     nl        number every line (like "nl -ba"), numbering continues across chunks
+ *     wc        count lines, words and bytes (like "wc"), partial counts are summed
+ *     upper     convert text to upper case
+ *     -e "cmd"  run "sh -c cmd" on every chunk (cmd must be chunk-independent)
+ *   When no input file is given, standard input is used, so hw1.c becomes:
+ *     ls -F | ./parallel_pipeline -k 4 nl
+ */
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define DEFAULT_WORKERS    4
+#define DEFAULT_CHUNK_SIZE (256 * 1024)  // 256KB of input per chunk
+#define MAX_WORKERS        64
+#define WINDOW_PER_WORKER  4             // chunks allowed in flight per worker
+
+enum filter_kind { FILTER_NL, FILTER_WC, FILTER_UPPER, FILTER_EXEC };
+
+// Header sent in front of every chunk going to a worker
+typedef struct {
+    uint64_t seq;        // sequence number of the chunk
+    uint64_t first_line; // line number of the first line in the chunk (for nl)
+    uint64_t len;        // number of payload bytes that follow
+} chunk_hdr;
+
+// Header sent in front of every result coming back from a worker
+typedef struct {
+    uint64_t seq;
+    uint64_t len;
+} result_hdr;
+
+// A growable byte buffer
+typedef struct {
+    char  *data;
+    size_t len;
+    size_t cap;
+} byte_buf;
+
+// Parent-side bookkeeping for one worker process
+typedef struct {
+    pid_t    pid;
+    int      to_fd;    // parent writes chunks here
+    int      from_fd;  // parent reads results here
+    byte_buf out;      // framed chunk waiting to be written
+    size_t   out_off;  // how much of out has been written
+    byte_buf in;       // partially received results
+} worker_t;
+
+// One slot of the reorder window
+typedef struct {
+    int   ready;
+    char *data;
+    size_t len;
+} slot_t;
+
+static enum filter_kind filter;
+static const char *exec_cmd;
+
+static void buf_reserve(byte_buf *b, size_t need) {
+    if (b->cap >= need) return;
+    size_t cap = b->cap ? b->cap : 4096;
+    while (cap < need) cap *= 2;
+    char *p = realloc(b->data, cap);
+    if (!p) {
+        perror("realloc");
+        exit(EXIT_FAILURE);
+    }
+    b->data = p;
+    b->cap = cap;
+}
+
+static void buf_append(byte_buf *b, const void *src, size_t len) {
+    buf_reserve(b, b->len + len);
+    memcpy(b->data + b->len, src, len);
+    b->len += len;
+}
+
+// read() until len bytes arrive; returns 0 on clean EOF before any byte
+static int read_full(int fd, void *dst, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = read(fd, (char *)dst + got, len - got);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("read");
+            exit(EXIT_FAILURE);
+        }
+        if (n == 0) {
+            if (got == 0) return 0;
+            fprintf(stderr, "Unexpected end of stream\n");
+            exit(EXIT_FAILURE);
+        }
+        got += n;
+    }
+    return 1;
+}
+
+// write() until every byte is out, retrying short writes
+static void write_full(int fd, const void *src, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(fd, (const char *)src + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EPIPE) perror("write");  // reader gone: stop quietly, as SIGPIPE would
+            exit(EXIT_FAILURE);
+        }
+        done += n;
+    }
+}
+
+/* -------------------------------------------
+   Filters (run inside the worker processes)
+   ------------------------------------------- */
+
+// Number every line starting at first_line
+static void filter_nl(const char *src, size_t len, uint64_t first_line, byte_buf *out) {
+    uint64_t line = first_line;
+    size_t start = 0;
+    char num[32];
+    while (start < len) {
+        const char *nl = memchr(src + start, '\n', len - start);
+        size_t end = nl ? (size_t)(nl - src) + 1 : len;
+        int n = snprintf(num, sizeof(num), "%6llu\t", (unsigned long long)line++);
+        buf_append(out, num, n);
+        buf_append(out, src + start, end - start);
+        start = end;
+    }
+}
+
+// Count lines, words and bytes; chunks are line-aligned so no word is split
+static void filter_wc(const char *src, size_t len, byte_buf *out) {
+    uint64_t counts[3] = {0, 0, len};
+    int in_word = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = src[i];
+        if (c == '\n') counts[0]++;
+        if (isspace(c)) {
+            in_word = 0;
+        } else if (!in_word) {
+            in_word = 1;
+            counts[1]++;
+        }
+    }
+    buf_append(out, counts, sizeof(counts));
+}
+
+static void filter_upper(const char *src, size_t len, byte_buf *out) {
+    buf_reserve(out, len);
+    for (size_t i = 0; i < len; i++) out->data[i] = toupper((unsigned char)src[i]);
+    out->len = len;
+}
+
+// Run "sh -c exec_cmd" with the chunk on its stdin and collect its stdout.
+// stdin is fed and stdout drained in the same poll() loop so a command that
+// writes before it has read everything cannot deadlock with us.
+static void filter_exec(const char *src, size_t len, byte_buf *out) {
+    int in_pipe[2], out_pipe[2];
+    if (pipe(in_pipe) == -1 || pipe(out_pipe) == -1) {
+        perror("pipe");
+        exit(EXIT_FAILURE);
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(EXIT_FAILURE);
+    }
+    if (pid == 0) {
+        dup2(in_pipe[0], STDIN_FILENO);
+        dup2(out_pipe[1], STDOUT_FILENO);
+        close(in_pipe[0]);
+        close(in_pipe[1]);
+        close(out_pipe[0]);
+        close(out_pipe[1]);
+        signal(SIGPIPE, SIG_DFL);  // an ignored signal would survive exec
+        execlp("sh", "sh", "-c", exec_cmd, (char *) NULL);
+        perror("execlp sh");
+        _exit(EXIT_FAILURE);
+    }
+    close(in_pipe[0]);
+    close(out_pipe[1]);
+    fcntl(in_pipe[1], F_SETFL, O_NONBLOCK);
+
+    size_t sent = 0;
+    int wfd = in_pipe[1];
+    if (len == 0) {
+        close(wfd);
+        wfd = -1;
+    }
+    for (;;) {
+        struct pollfd pfd[2] = {
+            { .fd = out_pipe[0], .events = POLLIN },
+            { .fd = wfd, .events = POLLOUT },
+        };
+        if (poll(pfd, wfd >= 0 ? 2 : 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            exit(EXIT_FAILURE);
+        }
+        if (wfd >= 0 && (pfd[1].revents & (POLLOUT | POLLERR | POLLHUP))) {
+            ssize_t n = write(wfd, src + sent, len - sent);
+            if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                // The command exited without reading everything; stop feeding it
+                sent = len;
+            } else if (n > 0) {
+                sent += n;
+            }
+            if (sent == len) {
+                close(wfd);
+                wfd = -1;
+            }
+        }
+        if (pfd[0].revents & (POLLIN | POLLHUP)) {
+            buf_reserve(out, out->len + 65536);
+            ssize_t n = read(out_pipe[0], out->data + out->len, 65536);
+            if (n < 0 && errno != EINTR) {
+                perror("read");
+                exit(EXIT_FAILURE);
+            }
+            if (n == 0) break;
+            if (n > 0) out->len += n;
+        }
+    }
+    if (wfd >= 0) close(wfd);
+    close(out_pipe[0]);
+    waitpid(pid, NULL, 0);
+}
+
+// Worker main loop: read a framed chunk, filter it, send back a framed result
+static void worker_loop(int in_fd, int out_fd) {
+    byte_buf chunk = {0}, result = {0};
+    chunk_hdr hdr;
+    while (read_full(in_fd, &hdr, sizeof(hdr))) {
+        buf_reserve(&chunk, hdr.len);
+        if (hdr.len) read_full(in_fd, chunk.data, hdr.len);
+        result.len = 0;
+        switch (filter) {
+        case FILTER_NL:    filter_nl(chunk.data, hdr.len, hdr.first_line, &result); break;
+        case FILTER_WC:    filter_wc(chunk.data, hdr.len, &result); break;
+        case FILTER_UPPER: filter_upper(chunk.data, hdr.len, &result); break;
+        case FILTER_EXEC:  filter_exec(chunk.data, hdr.len, &result); break;
+        }
+        result_hdr rh = { hdr.seq, result.len };
+        write_full(out_fd, &rh, sizeof(rh));
+        write_full(out_fd, result.data, result.len);
+    }
+    free(chunk.data);
+    free(result.data);
+}
+
+/* -------------------------------------------
+   Parent: chunking, dispatch and reassembly
+   ------------------------------------------- */
+
+static void spawn_workers(worker_t *w, int k) {
+    for (int i = 0; i < k; i++) {
+        int to[2], from[2];
+        if (pipe(to) == -1 || pipe(from) == -1) {
+            perror("pipe");
+            exit(EXIT_FAILURE);
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            // Drop the pipes of the workers created before us
+            for (int j = 0; j < i; j++) {
+                close(w[j].to_fd);
+                close(w[j].from_fd);
+            }
+            close(to[1]);
+            close(from[0]);
+            worker_loop(to[0], from[1]);
+            _exit(EXIT_SUCCESS);
+        }
+        close(to[0]);
+        close(from[1]);
+        memset(&w[i], 0, sizeof(w[i]));
+        w[i].pid = pid;
+        w[i].to_fd = to[1];
+        w[i].from_fd = from[0];
+        fcntl(w[i].to_fd, F_SETFL, O_NONBLOCK);
+        fcntl(w[i].from_fd, F_SETFL, O_NONBLOCK);
+    }
+}
+
+// Refill the input buffer and cut the next line-aligned chunk out of it.
+// Returns the chunk length, 0 when the input is exhausted.
+static size_t next_chunk(int in_fd, byte_buf *in, size_t chunk_size, int *eof) {
+    while (!*eof && in->len < chunk_size) {
+        ssize_t n = read(in_fd, in->data + in->len, in->cap - in->len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("Error reading input");
+            exit(EXIT_FAILURE);
+        }
+        if (n == 0) *eof = 1;
+        in->len += n;
+    }
+    if (in->len == 0) return 0;
+    if (in->len <= chunk_size && *eof) return in->len;
+
+    // Cut after the last newline inside the first chunk_size bytes
+    size_t limit = in->len < chunk_size ? in->len : chunk_size;
+    for (size_t i = limit; i > 0; i--) {
+        if (in->data[i - 1] == '\n') return i;
+    }
+    // A single line longer than the chunk: extend the cut to its end
+    const char *nl = memchr(in->data + limit, '\n', in->len - limit);
+    if (nl) return (size_t)(nl - in->data) + 1;
+    return in->len;
+}
+
+static size_t count_lines(const char *p, size_t len) {
+    size_t lines = 0;
+    const char *end = p + len;
+    while ((p = memchr(p, '\n', end - p)) != NULL) {
+        lines++;
+        p++;
+    }
+    return lines;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: ./parallel_pipeline [-k workers] [-c chunk_bytes] "
+                    "{nl|wc|upper|-e \"cmd\"} [input_file]\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+    int k = DEFAULT_WORKERS;
+    size_t chunk_size = DEFAULT_CHUNK_SIZE;
+    int argi = 1;
+
+    // Parse options
+    while (argi < argc && argv[argi][0] == '-' && strcmp(argv[argi], "-e") != 0) {
+        if (strcmp(argv[argi], "-k") == 0 && argi + 1 < argc) {
+            k = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "-c") == 0 && argi + 1 < argc) {
+            chunk_size = strtoull(argv[++argi], NULL, 10);
+        } else {
+            usage();
+        }
+        argi++;
+    }
+    if (argi >= argc || k < 1 || k > MAX_WORKERS || chunk_size == 0) usage();
+
+    if (strcmp(argv[argi], "nl") == 0) {
+        filter = FILTER_NL;
+    } else if (strcmp(argv[argi], "wc") == 0) {
+        filter = FILTER_WC;
+    } else if (strcmp(argv[argi], "upper") == 0) {
+        filter = FILTER_UPPER;
+    } else if (strcmp(argv[argi], "-e") == 0 && argi + 1 < argc) {
+        filter = FILTER_EXEC;
+        exec_cmd = argv[++argi];
+    } else {
+        usage();
+    }
+    argi++;
+
+    int in_fd = STDIN_FILENO;
+    if (argi < argc) {
+        in_fd = open(argv[argi], O_RDONLY);
+        if (in_fd == -1) {
+            perror("Error opening input file");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // A command like "head -1" may exit before reading its whole chunk, and
+    // a worker may die: get EPIPE from write() instead of being killed by
+    // SIGPIPE. Set before forking so the workers inherit it
+    signal(SIGPIPE, SIG_IGN);
+
+    worker_t workers[MAX_WORKERS];
+    spawn_workers(workers, k);
+
+    // Reorder window: result seq lands in slot seq % window
+    size_t window = (size_t)k * WINDOW_PER_WORKER;
+    slot_t *slots = calloc(window, sizeof(slot_t));
+    if (!slots) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+
+    byte_buf input = {0};
+    buf_reserve(&input, chunk_size * 2);
+    int input_eof = 0, input_done = 0;
+    uint64_t next_send = 0, next_emit = 0, next_line = 1;
+    uint64_t wc_totals[3] = {0, 0, 0};
+
+    while (!input_done || next_emit < next_send) {
+        // Dispatch: chunk next_send goes to worker next_send % k
+        while (!input_done && next_send - next_emit < window) {
+            worker_t *w = &workers[next_send % k];
+            if (w->out_off < w->out.len) break;  // that worker is still being fed
+            size_t len = next_chunk(in_fd, &input, chunk_size, &input_eof);
+            if (len == 0) {
+                input_done = 1;
+                break;
+            }
+            chunk_hdr hdr = { next_send, next_line, len };
+            w->out.len = 0;
+            w->out_off = 0;
+            buf_append(&w->out, &hdr, sizeof(hdr));
+            buf_append(&w->out, input.data, len);
+            next_line += count_lines(input.data, len);
+            memmove(input.data, input.data + len, input.len - len);
+            input.len -= len;
+            next_send++;
+        }
+        if (input_done && next_emit == next_send) break;
+
+        // Wait until a worker can take more input or has output for us
+        struct pollfd pfd[2 * MAX_WORKERS];
+        for (int i = 0; i < k; i++) {
+            pfd[2 * i].fd = workers[i].from_fd;
+            pfd[2 * i].events = POLLIN;
+            pfd[2 * i + 1].fd = workers[i].out_off < workers[i].out.len ? workers[i].to_fd : -1;
+            pfd[2 * i + 1].events = POLLOUT;
+        }
+        if (poll(pfd, 2 * k, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int i = 0; i < k; i++) {
+            worker_t *w = &workers[i];
+            if (pfd[2 * i + 1].revents & (POLLOUT | POLLERR | POLLHUP)) {
+                ssize_t n = write(w->to_fd, w->out.data + w->out_off, w->out.len - w->out_off);
+                if (n < 0 && errno == EPIPE) {
+                    fprintf(stderr, "Worker %d exited unexpectedly\n", i);
+                    exit(EXIT_FAILURE);
+                }
+                if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                    perror("Error writing to worker");
+                    exit(EXIT_FAILURE);
+                }
+                if (n > 0) w->out_off += n;
+            }
+            if (pfd[2 * i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                buf_reserve(&w->in, w->in.len + 65536);
+                ssize_t n = read(w->from_fd, w->in.data + w->in.len, 65536);
+                if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                    perror("Error reading from worker");
+                    exit(EXIT_FAILURE);
+                }
+                if (n == 0) {
+                    fprintf(stderr, "Worker %d exited unexpectedly\n", i);
+                    exit(EXIT_FAILURE);
+                }
+                if (n > 0) w->in.len += n;
+
+                // Move every complete result into its reorder slot
+                size_t off = 0;
+                while (w->in.len - off >= sizeof(result_hdr)) {
+                    result_hdr rh;
+                    memcpy(&rh, w->in.data + off, sizeof(rh));
+                    if (w->in.len - off - sizeof(rh) < rh.len) break;
+                    slot_t *s = &slots[rh.seq % window];
+                    s->data = malloc(rh.len ? rh.len : 1);
+                    if (!s->data) {
+                        perror("malloc");
+                        exit(EXIT_FAILURE);
+                    }
+                    memcpy(s->data, w->in.data + off + sizeof(rh), rh.len);
+                    s->len = rh.len;
+                    s->ready = 1;
+                    off += sizeof(rh) + rh.len;
+                }
+                memmove(w->in.data, w->in.data + off, w->in.len - off);
+                w->in.len -= off;
+            }
+        }
+
+        // Emit every result that is next in sequence
+        while (next_emit < next_send && slots[next_emit % window].ready) {
+            slot_t *s = &slots[next_emit % window];
+            if (filter == FILTER_WC) {
+                uint64_t part[3];
+                memcpy(part, s->data, sizeof(part));
+                for (int j = 0; j < 3; j++) wc_totals[j] += part[j];
+            } else {
+                write_full(STDOUT_FILENO, s->data, s->len);
+            }
+            free(s->data);
+            s->data = NULL;
+            s->ready = 0;
+            next_emit++;
+        }
+    }
+
+    if (filter == FILTER_WC) {
+        printf("%7llu %7llu %7llu\n", (unsigned long long)wc_totals[0],
+               (unsigned long long)wc_totals[1], (unsigned long long)wc_totals[2]);
+    }
+
+    // Closing the chunk pipes tells every worker to exit
+    for (int i = 0; i < k; i++) {
+        close(workers[i].to_fd);
+        close(workers[i].from_fd);
+        free(workers[i].out.data);
+        free(workers[i].in.data);
+    }
+    for (int i = 0; i < k; i++) waitpid(workers[i].pid, NULL, 0);
+
+    free(slots);
+    free(input.data);
+    if (in_fd != STDIN_FILENO) close(in_fd);
+    return 0;
+}
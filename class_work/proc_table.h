@@ -0,0 +1,329 @@
+/*
+ * proc_table.h - structure-of-arrays process table for the lab3 schedulers.
+ *
+ * lab3_fcfs.c computes waiting times with the serial recurrence
+ * wt[i] = bt[i-1] + wt[i-1], lab3_srtf.c and lab3_prioritySche.c re-add all
+ * earlier bursts for every process (O(n^2)), and all of them total in
+ * float, which stops being exact past 2^24. Here:
+ *   - every attribute is its own 64-byte aligned int64_t column (pid,
+ *     arrival, burst, priority, start, finish), so the loops stream through
+ *     memory and vectorize,
+ *   - a non-preemptive schedule in table order is a scan: with arrivals,
+ *     finish[i] = max(finish[i-1], arrival[i]) + burst[i], and each block of
+ *     processes folds into f(x) = max(x + B, C), which composes, so blocks
+ *     are summarised in parallel, chained serially and then filled in
+ *     parallel; where nobody in a block arrives late the fill is a plain
+ *     prefix sum of the bursts (AVX2, 4 lanes at a time),
+ *   - totals and maxima are 64-bit integer reductions, exact at any size,
+ *   - ordering by burst (SJF) or priority is a stable LSD radix sort,
+ *     O(n) instead of a selection sort.
+ * Pass a pf_pool from parallel_for.h to spread the blocks over threads, or
+ * NULL to run everything on the calling thread.
+ *
+ * Interface:
+ *   pt_alloc() / pt_free()   columns for n processes (zeroed)
+ *   pt_sort()                stable reorder of every column by a key column
+ *   pt_schedule()            start/finish for running the table in order
+ *   pt_metrics()             total/max waiting and turnaround times
+ *
+ * Header only: #include "proc_table.h" (compile with -mavx2 for the SIMD scan).
+ */
+#ifndef PROC_TABLE_H
+#define PROC_TABLE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "parallel_for.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define PT_ALIGN 64
+#define PT_BLOCK (1 << 16)  // processes per scan block
+
+typedef struct {
+    size_t n;
+    int64_t *pid, *arrival, *burst, *priority, *start, *finish;
+} proc_table;
+
+typedef struct {
+    int64_t total_wait;        // sum of start - arrival
+    int64_t total_turnaround;  // sum of finish - arrival
+    int64_t max_wait;
+    int64_t makespan;          // finish time of the last process
+} proc_metrics;
+
+static inline int64_t *pt_column(size_t n) {
+    size_t bytes = (n * sizeof(int64_t) + PT_ALIGN - 1) / PT_ALIGN * PT_ALIGN;
+    int64_t *c = aligned_alloc(PT_ALIGN, bytes ? bytes : PT_ALIGN);
+    if (c) memset(c, 0, bytes);
+    return c;
+}
+
+static inline void pt_free(proc_table *t) {
+    free(t->pid);
+    free(t->arrival);
+    free(t->burst);
+    free(t->priority);
+    free(t->start);
+    free(t->finish);
+    memset(t, 0, sizeof(*t));
+}
+
+// Returns -1 when out of memory
+static inline int pt_alloc(proc_table *t, size_t n) {
+    t->n = n;
+    t->pid = pt_column(n);
+    t->arrival = pt_column(n);
+    t->burst = pt_column(n);
+    t->priority = pt_column(n);
+    t->start = pt_column(n);
+    t->finish = pt_column(n);
+    if (!t->pid || !t->arrival || !t->burst || !t->priority || !t->start || !t->finish) {
+        pt_free(t);
+        return -1;
+    }
+    return 0;
+}
+
+/* -------------------------------------------
+   Stable radix sort
+   ------------------------------------------- */
+
+// Reorder every column so key is ascending (or descending); equal keys keep
+// their current order, which is the FCFS tie-break the lab programs want.
+// key must be one of t's columns. Returns -1 when out of memory.
+static inline int pt_sort(proc_table *t, const int64_t *key, int descending) {
+    size_t n = t->n;
+    uint64_t *k = malloc(n * sizeof(uint64_t)), *k2 = malloc(n * sizeof(uint64_t));
+    uint32_t *idx = malloc(n * sizeof(uint32_t)), *idx2 = malloc(n * sizeof(uint32_t));
+    int64_t *tmp = pt_column(n);
+    size_t *count = malloc(65536 * sizeof(size_t));
+    if (!k || !k2 || !idx || !idx2 || !tmp || !count || n > UINT32_MAX) {
+        free(k), free(k2), free(idx), free(idx2), free(tmp), free(count);
+        return -1;
+    }
+
+    // Signed -> unsigned order-preserving; flip everything for descending
+    uint64_t all_or = 0, all_and = ~0ULL;
+    for (size_t i = 0; i < n; i++) {
+        k[i] = (uint64_t)key[i] ^ (1ULL << 63);
+        if (descending) k[i] = ~k[i];
+        all_or |= k[i];
+        all_and &= k[i];
+        idx[i] = (uint32_t)i;
+    }
+
+    // 16-bit digits; a digit that is the same for every key is skipped
+    for (int shift = 0; shift < 64; shift += 16) {
+        if ((((all_or ^ all_and) >> shift) & 0xFFFF) == 0) continue;
+        memset(count, 0, 65536 * sizeof(size_t));
+        for (size_t i = 0; i < n; i++) count[(k[i] >> shift) & 0xFFFF]++;
+        size_t sum = 0;
+        for (size_t d = 0; d < 65536; d++) {
+            size_t c = count[d];
+            count[d] = sum;
+            sum += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t pos = count[(k[i] >> shift) & 0xFFFF]++;
+            k2[pos] = k[i];
+            idx2[pos] = idx[i];
+        }
+        uint64_t *tk = k;
+        k = k2;
+        k2 = tk;
+        uint32_t *ti = idx;
+        idx = idx2;
+        idx2 = ti;
+    }
+
+    // Gather every column through the permutation
+    int64_t **cols[] = { &t->pid, &t->arrival, &t->burst, &t->priority, &t->start, &t->finish };
+    for (size_t c = 0; c < sizeof(cols) / sizeof(cols[0]); c++) {
+        int64_t *src = *cols[c];
+        for (size_t i = 0; i < n; i++) tmp[i] = src[idx[i]];
+        *cols[c] = tmp;
+        tmp = src;
+    }
+
+    free(k), free(k2), free(idx), free(idx2), free(tmp), free(count);
+    return 0;
+}
+
+/* -------------------------------------------
+   Schedule scan
+   ------------------------------------------- */
+
+typedef struct {
+    int64_t sum;          // B: total burst of the block
+    int64_t fold;         // C: finish of the block's last process if the CPU is free from -inf
+    int64_t max_arrival;
+    int64_t carry;        // finish time before the block (filled by the serial pass)
+} pt_block;
+
+typedef struct {
+    proc_table *t;
+    pt_block *blocks;
+} pt_scan_ctx;
+
+// Run body over nblocks blocks, on the pool if there is one
+static inline void pt_blocks(pf_pool *pool, size_t nblocks, pf_body body, void *arg) {
+    if (pool) pf_for(pool, 0, nblocks, 1, body, arg);
+    else body(0, nblocks, 0, NULL, arg);
+}
+
+static inline void pt_summarise(uint64_t first, uint64_t last, int worker, void *partial, void *arg) {
+    (void)worker, (void)partial;
+    pt_scan_ctx *ctx = arg;
+    const proc_table *t = ctx->t;
+    for (uint64_t b = first; b < last; b++) {
+        size_t lo = b * PT_BLOCK, hi = lo + PT_BLOCK < t->n ? lo + PT_BLOCK : t->n;
+        int64_t sum = 0, fold = INT64_MIN / 2, max_arrival = INT64_MIN;
+        for (size_t i = lo; i < hi; i++) {
+            sum += t->burst[i];
+            fold = (fold > t->arrival[i] ? fold : t->arrival[i]) + t->burst[i];
+            if (t->arrival[i] > max_arrival) max_arrival = t->arrival[i];
+        }
+        ctx->blocks[b] = (pt_block){ sum, fold, max_arrival, 0 };
+    }
+}
+
+static inline void pt_fill(uint64_t first, uint64_t last, int worker, void *partial, void *arg) {
+    (void)worker, (void)partial;
+    pt_scan_ctx *ctx = arg;
+    proc_table *t = ctx->t;
+    for (uint64_t b = first; b < last; b++) {
+        size_t lo = b * PT_BLOCK, hi = lo + PT_BLOCK < t->n ? lo + PT_BLOCK : t->n;
+        int64_t f = ctx->blocks[b].carry;
+        size_t i = lo;
+        if (ctx->blocks[b].max_arrival <= f) {
+            // Nobody in this block waits for an arrival: a prefix sum of bursts
+#if defined(__AVX2__)
+            __m256i carry = _mm256_set1_epi64x(f), zero = _mm256_setzero_si256();
+            for (; i + 4 <= hi; i += 4) {
+                __m256i x = _mm256_load_si256((const __m256i *)(t->burst + i));
+                __m256i s = _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03);
+                __m256i p = _mm256_add_epi64(x, s);  // [a, a+b, b+c, c+d]
+                s = _mm256_blend_epi32(_mm256_permute4x64_epi64(p, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F);
+                p = _mm256_add_epi64(_mm256_add_epi64(p, s), carry);
+                _mm256_store_si256((__m256i *)(t->finish + i), p);
+                _mm256_store_si256((__m256i *)(t->start + i), _mm256_sub_epi64(p, x));
+                carry = _mm256_permute4x64_epi64(p, _MM_SHUFFLE(3, 3, 3, 3));
+            }
+            f = _mm256_extract_epi64(carry, 0);
+#endif
+            for (; i < hi; i++) {
+                t->start[i] = f;
+                f += t->burst[i];
+                t->finish[i] = f;
+            }
+        } else {
+            for (; i < hi; i++) {
+                int64_t s = f > t->arrival[i] ? f : t->arrival[i];
+                t->start[i] = s;
+                f = s + t->burst[i];
+                t->finish[i] = f;
+            }
+        }
+    }
+}
+
+// Run the processes one after another in table order (non-preemptive),
+// the CPU being free from time 0. Returns -1 when out of memory.
+static inline int pt_schedule(proc_table *t, pf_pool *pool) {
+    size_t nblocks = (t->n + PT_BLOCK - 1) / PT_BLOCK;
+    pt_scan_ctx ctx = { t, malloc((nblocks ? nblocks : 1) * sizeof(pt_block)) };
+    if (!ctx.blocks) return -1;
+
+    pt_blocks(pool, nblocks, pt_summarise, &ctx);
+    int64_t x = 0;
+    for (size_t b = 0; b < nblocks; b++) {
+        ctx.blocks[b].carry = x;
+        // f(x) = max(x + B, C)
+        x = x + ctx.blocks[b].sum > ctx.blocks[b].fold ? x + ctx.blocks[b].sum : ctx.blocks[b].fold;
+    }
+    pt_blocks(pool, nblocks, pt_fill, &ctx);
+
+    free(ctx.blocks);
+    return 0;
+}
+
+/* -------------------------------------------
+   Metrics
+   ------------------------------------------- */
+
+static inline void pt_reduce_body(uint64_t first, uint64_t last, int worker, void *partial, void *arg) {
+    (void)worker;
+    const proc_table *t = arg;
+    proc_metrics *m = partial;
+    for (uint64_t b = first; b < last; b++) {
+        size_t lo = b * PT_BLOCK, hi = lo + PT_BLOCK < t->n ? lo + PT_BLOCK : t->n;
+        size_t i = lo;
+        int64_t wait = 0, turnaround = 0, max_wait = m->max_wait;
+#if defined(__AVX2__)
+        __m256i vw = _mm256_setzero_si256(), vt = _mm256_setzero_si256();
+        __m256i vmax = _mm256_set1_epi64x(max_wait);
+        for (; i + 4 <= hi; i += 4) {
+            __m256i a = _mm256_load_si256((const __m256i *)(t->arrival + i));
+            __m256i w = _mm256_sub_epi64(_mm256_load_si256((const __m256i *)(t->start + i)), a);
+            vw = _mm256_add_epi64(vw, w);
+            vt = _mm256_add_epi64(vt, _mm256_sub_epi64(_mm256_load_si256((const __m256i *)(t->finish + i)), a));
+            vmax = _mm256_blendv_epi8(vmax, w, _mm256_cmpgt_epi64(w, vmax));
+        }
+        int64_t lanes[12] __attribute__((aligned(32)));
+        _mm256_store_si256((__m256i *)lanes, vw);
+        _mm256_store_si256((__m256i *)(lanes + 4), vt);
+        _mm256_store_si256((__m256i *)(lanes + 8), vmax);
+        for (int l = 0; l < 4; l++) {
+            wait += lanes[l];
+            turnaround += lanes[4 + l];
+            if (lanes[8 + l] > max_wait) max_wait = lanes[8 + l];
+        }
+#endif
+        for (; i < hi; i++) {
+            int64_t w = t->start[i] - t->arrival[i];
+            wait += w;
+            turnaround += t->finish[i] - t->arrival[i];
+            if (w > max_wait) max_wait = w;
+        }
+        m->total_wait += wait;
+        m->total_turnaround += turnaround;
+        m->max_wait = max_wait;
+        if (hi == t->n && hi > 0) m->makespan = t->finish[hi - 1];
+    }
+}
+
+static inline void pt_init_metrics(void *partial, void *arg) {
+    (void)arg;
+    *(proc_metrics *)partial = (proc_metrics){ 0, 0, INT64_MIN, 0 };
+}
+
+static inline void pt_combine_metrics(void *into, const void *from, void *arg) {
+    (void)arg;
+    proc_metrics *m = into;
+    const proc_metrics *f = from;
+    m->total_wait += f->total_wait;
+    m->total_turnaround += f->total_turnaround;
+    if (f->max_wait > m->max_wait) m->max_wait = f->max_wait;
+    if (f->makespan > m->makespan) m->makespan = f->makespan;
+}
+
+// Totals over the table after pt_schedule()
+static inline proc_metrics pt_metrics(const proc_table *t, pf_pool *pool) {
+    proc_metrics m;
+    pt_init_metrics(&m, NULL);
+    size_t nblocks = (t->n + PT_BLOCK - 1) / PT_BLOCK;
+    if (pool && nblocks) {
+        pf_reduce(pool, 0, nblocks, 1, pt_reduce_body, (void *)t, sizeof(m), pt_init_metrics, pt_combine_metrics,
+                  &m);
+    } else {
+        pt_reduce_body(0, nblocks, 0, &m, (void *)t);
+    }
+    if (t->n == 0) m.max_wait = 0;
+    return m;
+}
+
+#endif
@@ -1,18 +1,143 @@
 #include <stdio.h>      // Include standard I/O library (not used but commonly included)
 #include <fcntl.h>      // Include file control options for open()
-#include <unistd.h>     // Include system call functions like read(), write(), lseek(), and close()
+#include <unistd.h>     // Include system call functions like pread(), write(), and close()
 #include <sys/stat.h>   // Include stat() for getting file information
-#include <stdlib.h>     // Include standard library for exit()
+#include <sys/mman.h>   // Include mmap() for the memory-mapped source path
+#include <stdlib.h>     // Include standard library for exit() and malloc()
+#include <string.h>     // Include strlen() and strcmp()
+#include <errno.h>      // Include errno to retry interrupted system calls
+#include <stdint.h>     // Include fixed-width integers for the word-at-a-time reverse
+#include <pthread.h>    // Include threads for the parallel mode
 
-#define BUF_SIZE 12  // Define the buffer size for reading and writing
+// The byte-shuffle kernels are used when the compiler targets them:
+// gcc -O2 -mavx2 -pthread reversefile.c -o reverse_file  (or -mssse3)
+#if defined(__AVX2__)
+#include <immintrin.h>  // 32-byte byte shuffle (vpshufb)
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>  // 16-byte byte shuffle (pshufb)
+#endif
 
-// Function to reverse a block of data using pointer arithmetic 
-//Takes in the buffer being used and the size of the file(bytes)
+// Define the block size for reading and writing.
+// The old 12-byte buffer cost an lseek + read + write for every 12 bytes,
+// so a multi-GB file took about a billion system calls. 8MB blocks cut that
+// to a few hundred per GB.
+#define BLOCK_SIZE (8 * 1024 * 1024)
+
+// Print an error message on stderr without going through stdio
+static void error_msg(const char *msg) {
+    write(STDERR_FILENO, msg, strlen(msg));
+}
+
+// Write all len bytes, retrying short writes
+static int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// Read exactly len bytes at offset, retrying short reads
+static int pread_all(int fd, char *buf, size_t len, off_t offset) {
+    while (len > 0) {
+        ssize_t n = pread(fd, buf, len, offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;  // error, or the file shrank under us
+        buf += n;
+        offset += n;
+        len -= n;
+    }
+    return 0;
+}
+
+#if defined(__AVX2__)
+#define VEC_BYTES 32
+typedef __m256i vec_t;
+// Reverse the 32 bytes at p: shuffle inside each 16-byte lane, then swap lanes
+static inline vec_t load_reversed(const char *p) {
+    const __m256i rev = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                         15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)p), rev);
+    return _mm256_permute2x128_si256(v, v, 0x01);
+}
+static inline void store_vec(char *p, vec_t v) {
+    _mm256_storeu_si256((__m256i *)p, v);
+}
+#elif defined(__SSSE3__)
+#define VEC_BYTES 16
+typedef __m128i vec_t;
+// Reverse the 16 bytes at p with one pshufb
+static inline vec_t load_reversed(const char *p) {
+    const __m128i rev = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p), rev);
+}
+static inline void store_vec(char *p, vec_t v) {
+    _mm_storeu_si128((__m128i *)p, v);
+}
+#endif
+
+// Copy len bytes from src to dst in reverse order: dst[i] = src[len - 1 - i].
+// The vector loop takes 32 (AVX2) or 16 (SSSE3) bytes off the end of src,
+// reverses them with a byte shuffle and stores them at the front of dst.
+// Without those, 8 bytes at a time are reversed with a byte swap.
+static void reverse_copy(char *dst, const char *src, size_t len) {
+    const char *s = src + len;  // walks backward through src
+    size_t i = 0;
+
+#ifdef VEC_BYTES
+    for (; i + VEC_BYTES <= len; i += VEC_BYTES) {
+        s -= VEC_BYTES;
+        store_vec(dst + i, load_reversed(s));
+    }
+#endif
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        s -= 8;
+        memcpy(&w, s, 8);
+        w = __builtin_bswap64(w);
+        memcpy(dst + i, &w, 8);
+    }
+    for (; i < len; i++) {
+        dst[i] = *--s;
+    }
+}
+
+// Function to reverse a block of data in place
+// Takes in the buffer being used and the size of the block(bytes)
 void reverse_buffer(char *buffer, ssize_t len) { //ssize_t signed long int, can return -1, holds bits
     char *start = buffer;         // Pointer to the start of the buffer
     char *end = buffer + len - 1; // Pointer to the end of the buffer
 
-    // Swap characters from start to end to reverse the buffer content
+#ifdef VEC_BYTES
+    // Swap whole vectors from both ends, reversing each one on the way
+    while (end - start + 1 >= 2 * VEC_BYTES) {
+        vec_t a = load_reversed(start);
+        vec_t b = load_reversed(end - (VEC_BYTES - 1));
+        store_vec(start, b);
+        store_vec(end - (VEC_BYTES - 1), a);
+        start += VEC_BYTES;
+        end -= VEC_BYTES;
+    }
+#endif
+    // Then 8-byte words the same way
+    while (end - start + 1 >= 16) {
+        uint64_t a, b;
+        memcpy(&a, start, 8);
+        memcpy(&b, end - 7, 8);
+        a = __builtin_bswap64(a);
+        b = __builtin_bswap64(b);
+        memcpy(start, &b, 8);
+        memcpy(end - 7, &a, 8);
+        start += 8;
+        end -= 8;
+    }
+
+    // Swap the remaining characters one at a time
     while (start < end) {
         char temp = *start;  // Store the character at the start pointer
         *start = *end;       // Swap start with end
@@ -22,17 +147,199 @@ void reverse_buffer(char *buffer, ssize_t len) { //ssize_t signed long int, can
     }
 }
 
+// Reverse through an mmap of the source: each output block is built by
+// reverse-copying straight out of the mapping, then written in one call
+static int reverse_mmap(int src_fd, int dest_fd, off_t file_size, char *out) {
+    char *src = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, src_fd, 0);
+    if (src == MAP_FAILED) return -1;
+
+    off_t offset = file_size;
+    while (offset > 0) {
+        size_t len = (offset >= BLOCK_SIZE) ? BLOCK_SIZE : (size_t)offset;
+        offset -= len;
+        // Ask the kernel to start reading the block after this one
+        if (offset > 0) {
+            off_t ahead = offset >= BLOCK_SIZE ? offset - BLOCK_SIZE : 0;
+            off_t page = ahead & ~((off_t)sysconf(_SC_PAGESIZE) - 1);
+            madvise(src + page, offset - page, MADV_WILLNEED);
+        }
+        reverse_copy(out, src + offset, len);
+        if (write_all(dest_fd, out, len) == -1) {
+            error_msg("Error writing to destination file\n");
+            munmap(src, file_size);
+            return 1;
+        }
+    }
+    munmap(src, file_size);
+    return 0;
+}
+
+// Reverse with large pread() blocks taken from the end of the file;
+// each block is reverse-copied into out and written in one call
+static int reverse_pread(int src_fd, int dest_fd, off_t file_size, char *buffer, char *out) {
+    off_t offset = file_size; // Offset to track the current position in the file
+    while (offset > 0) {
+        // Determine how many bytes to read (either BLOCK_SIZE or remaining bytes)
+        size_t len = (offset >= BLOCK_SIZE) ? BLOCK_SIZE : (size_t)offset;
+        offset -= len;  // Move the offset backward
+
+        // pread() reads at an offset without a separate lseek()
+        if (pread_all(src_fd, buffer, len, offset) == -1) {
+            error_msg("Error reading from source file\n");
+            return 1;
+        }
+        reverse_copy(out, buffer, len);
+        if (write_all(dest_fd, out, len) == -1) {
+            error_msg("Error writing to destination file\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* -------------------------------------------
+   In-place and multi-threaded modes
+   Work is cut into numbered jobs and every thread grabs the next job number
+   with an atomic add, so fast threads simply take more jobs.
+   - Copy job j writes destination block j (offset j * BLOCK_SIZE), which is
+     the reverse of the j-th block counted from the end of the source.
+   - In-place job j swaps the mirrored blocks [j*B, j*B + len) and
+     [size - j*B - len, size - j*B), reversing both, so only one copy of the
+     file is ever on disk. The middle byte of an odd-sized file stays put.
+   ------------------------------------------- */
+
+typedef struct {
+    int src_fd;           // file to read (the same file as dest_fd in place)
+    int dest_fd;
+    off_t file_size;
+    int in_place;
+    long jobs;            // total number of jobs
+    long next_job;        // shared job counter
+    int failed;           // set by any thread that hits an I/O error
+} reverse_job;
+
+// Write all len bytes at offset, retrying short writes
+static int pwrite_all(int fd, const char *buf, size_t len, off_t offset) {
+    while (len > 0) {
+        ssize_t n = pwrite(fd, buf, len, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        offset += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static void *reverse_worker(void *arg) {
+    reverse_job *job = arg;
+    char *a = malloc(BLOCK_SIZE);
+    char *b = malloc(BLOCK_SIZE);
+    if (a == NULL || b == NULL) {
+        error_msg("Error allocating block buffers\n");
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+    }
+
+    long j;
+    while (a && b && !__atomic_load_n(&job->failed, __ATOMIC_RELAXED) &&
+           (j = __atomic_fetch_add(&job->next_job, 1, __ATOMIC_RELAXED)) < job->jobs) {
+        off_t front = (off_t)j * BLOCK_SIZE;
+        int ok;
+        if (job->in_place) {
+            // Swap a mirrored pair; both halves shrink to meet in the middle
+            off_t half = job->file_size / 2;
+            size_t len = (half - front >= BLOCK_SIZE) ? BLOCK_SIZE : (size_t)(half - front);
+            off_t back = job->file_size - front - len;
+            ok = pread_all(job->src_fd, a, len, front) == 0 &&
+                 pread_all(job->src_fd, b, len, back) == 0;
+            if (ok) {
+                reverse_buffer(a, len);
+                reverse_buffer(b, len);
+                ok = pwrite_all(job->dest_fd, b, len, front) == 0 &&
+                     pwrite_all(job->dest_fd, a, len, back) == 0;
+            }
+        } else {
+            // Destination block j comes from the j-th block from the end
+            size_t len = (job->file_size - front >= BLOCK_SIZE) ? BLOCK_SIZE
+                                                               : (size_t)(job->file_size - front);
+            ok = pread_all(job->src_fd, a, len, job->file_size - front - len) == 0;
+            if (ok) {
+                reverse_copy(b, a, len);
+                ok = pwrite_all(job->dest_fd, b, len, front) == 0;
+            }
+        }
+        if (!ok) {
+            error_msg("Error reading or writing a block\n");
+            __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    free(a);
+    free(b);
+    return NULL;
+}
+
+// Run the copy or in-place reversal with num_threads threads
+static int reverse_parallel(int src_fd, int dest_fd, off_t file_size, int in_place, int num_threads) {
+    reverse_job job = {0};
+    job.src_fd = src_fd;
+    job.dest_fd = dest_fd;
+    job.file_size = file_size;
+    job.in_place = in_place;
+    off_t span = in_place ? file_size / 2 : file_size;  // bytes covered by the jobs
+    job.jobs = (long)((span + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+    pthread_t threads[num_threads];
+    int started = 0;
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&threads[i], NULL, reverse_worker, &job) != 0) {
+            error_msg("Error creating thread\n");
+            break;
+        }
+        started++;
+    }
+    if (started == 0) reverse_worker(&job);  // no threads at all: do it here
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    return job.failed ? 1 : 0;
+}
+
 int main(int argc, char *argv[]) {
-    // Check if the correct number of arguments are provided
-    if (argc != 3) {
-        write(STDERR_FILENO, "Usage: ./reverse_file source_file destination_file\n", 52);
+    // Optional switches:
+    //   --mmap        memory-mapped source path (single-threaded copy)
+    //   --in-place    reverse the file itself instead of writing a copy
+    //   --threads N   use N threads (pread/pwrite of independent blocks)
+    int use_mmap = 0, in_place = 0, num_threads = 1;
+    int argi = 1;
+    while (argi < argc && strncmp(argv[argi], "--", 2) == 0) {
+        if (strcmp(argv[argi], "--mmap") == 0) {
+            use_mmap = 1;
+        } else if (strcmp(argv[argi], "--in-place") == 0) {
+            in_place = 1;
+        } else if (strcmp(argv[argi], "--threads") == 0 && argi + 1 < argc) {
+            num_threads = atoi(argv[++argi]);
+        } else {
+            break;
+        }
+        argi++;
+    }
+
+    // Check if the correct number of arguments are provided. The mmap path
+    // is single-threaded and copies only, so it cannot go with the others
+    if (argc - argi != (in_place ? 1 : 2) || num_threads < 1 || num_threads > 256 ||
+        (use_mmap && (num_threads > 1 || in_place))) {
+        error_msg("Usage: ./reverse_file [--mmap | --threads N] source_file destination_file\n"
+                  "       ./reverse_file --in-place [--threads N] file\n");
         return 1;
     }
 
-    // Open the source file in read-only mode
-    int src_fd = open(argv[1], O_RDONLY);
+    // Open the source file (read-write when it is reversed in place)
+    int src_fd = open(argv[argi], in_place ? O_RDWR : O_RDONLY);
     if (src_fd == -1) {  // Check if file opening failed
-        write(STDERR_FILENO, "Error opening source file\n", 26);
+        error_msg("Error opening source file\n");
         return 1;
     }
 
@@ -41,63 +348,77 @@ int main(int argc, char *argv[]) {
     //has to be a struct
     struct stat file_stat;
     if (fstat(src_fd, &file_stat) == -1) {  // Check if stat() call failed
-        write(STDERR_FILENO, "Error getting file size\n", 24);
+        error_msg("Error getting file size\n");
         close(src_fd);  // Close source file before exiting
         return 1;
     }
     //.st_size gives the total number of bytes in the fil
     off_t file_size = file_stat.st_size;  // Store the file size
 
-    // Open or create the destination file with write-only permission
-    int dest_fd = open(argv[2], O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (in_place) {
+        int status = reverse_parallel(src_fd, src_fd, file_size, 1, num_threads);
+        close(src_fd);
+        return status;
+    }
+
+    // Open or create the destination file with write-only permission.
+    // It is truncated (not appended to) so re-runs do not concatenate copies,
+    // but only after checking it is not the source file itself.
+    int dest_fd = open(argv[argi + 1], O_WRONLY | O_CREAT, 0644);
     if (dest_fd == -1) {  // Check if file opening/creation failed
-        write(STDERR_FILENO, "Error opening destination file\n", 31);
+        error_msg("Error opening destination file\n");
         close(src_fd);  // Close source file before exiting
         return 1;
     }
+    struct stat dest_stat;
+    if (fstat(dest_fd, &dest_stat) == -1 ||
+        (dest_stat.st_dev == file_stat.st_dev && dest_stat.st_ino == file_stat.st_ino)) {
+        error_msg("Destination is the source file; use --in-place\n");
+        close(src_fd);
+        close(dest_fd);
+        return 1;
+    }
+    if (ftruncate(dest_fd, 0) == -1) {
+        error_msg("Error truncating destination file\n");
+        close(src_fd);
+        close(dest_fd);
+        return 1;
+    }
 
-    char buffer[BUF_SIZE];    // Buffer to store data from the file
-    off_t offset = file_size; // Offset to track the current position in the file
-    ssize_t bytes_read, bytes_to_read; // Variables to hold read/write sizes
-
-    // Read the file in reverse, block by block
-    while (offset > 0) {
-        // Determine how many bytes to read (either BUF_SIZE or remaining bytes)
-        bytes_to_read = (offset >= BUF_SIZE) ? BUF_SIZE : offset;
-        offset -= bytes_to_read;  // Move the offset backward
-
-        // Move the file pointer to the correct position for reading
-        if (lseek(src_fd, offset, SEEK_SET) == -1) {
-            write(STDERR_FILENO, "Error seeking in source file\n", 29);
-            close(src_fd);
-            close(dest_fd);
-            return 1;
-        }
-
-        // Read the block of data from the file
-        bytes_read = read(src_fd, buffer, bytes_to_read);
-        if (bytes_read == -1) {  // Check if reading failed
-            write(STDERR_FILENO, "Error reading from source file\n", 31);
-            close(src_fd);
-            close(dest_fd);
-            return 1;
-        }
+    if (num_threads > 1) {
+        int status = reverse_parallel(src_fd, dest_fd, file_size, 0, num_threads);
+        close(src_fd);
+        close(dest_fd);
+        return status;
+    }
 
-        // Reverse the block of data
-        reverse_buffer(buffer, bytes_read);
+    // Two large block buffers (input and reversed output), allocated once
+    char *buffer = malloc(BLOCK_SIZE);
+    char *out = malloc(BLOCK_SIZE);
+    if (buffer == NULL || out == NULL) {
+        error_msg("Error allocating block buffers\n");
+        free(buffer);
+        free(out);
+        close(src_fd);
+        close(dest_fd);
+        return 1;
+    }
 
-        // Write the reversed block to the destination file
-        if (write(dest_fd, buffer, bytes_read) == -1) {
-            write(STDERR_FILENO, "Error writing to destination file\n", 33);
-            close(src_fd);
-            close(dest_fd);
-            return 1;
+    int status;
+    if (use_mmap && file_size > 0) {
+        status = reverse_mmap(src_fd, dest_fd, file_size, out);
+        if (status == -1) {  // mmap not possible here, use pread() instead
+            status = reverse_pread(src_fd, dest_fd, file_size, buffer, out);
         }
+    } else {
+        status = reverse_pread(src_fd, dest_fd, file_size, buffer, out);
     }
 
     // Close file descriptors to free resources
+    free(buffer);
+    free(out);
     close(src_fd);
     close(dest_fd);
 
-    return 0;  // Return success
+    return status;  // Return success
 }
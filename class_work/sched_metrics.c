@@ -0,0 +1,153 @@
+/*
+ * Scheduling-metrics benchmark for proc_table.h.
+ *
+ * Generates a synthetic trace of n processes (random bursts and priorities,
+ * optionally Poisson arrivals), orders it for FCFS, SJF or priority
+ * scheduling like the lab3 programs do, and times:
+ *   - the lab-style serial loop with float totals (wt[i] = bt[i-1] + wt[i-1]),
+ *   - pt_schedule() + pt_metrics() on a work-stealing pool.
+ * The 64-bit totals are checked against a plain serial reference, and the
+ * float totals show how far the old programs drift on big traces.
+ *
+ * Usage: ./sched_metrics [-n processes] [-t threads] [-a mean_gap] [-p fcfs|sjf|priority|all]
+ *   -a  mean time between arrivals (default 0: everything arrives at 0)
+ * Build: gcc -O2 -mavx2 -pthread sched_metrics.c -o sched_metrics
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "proc_table.h"
+
+#define DEFAULT_PROCESSES 10000000
+#define MAX_BURST         100
+#define MAX_PRIORITY      10
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t xorshift64(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *s = x;
+}
+
+static void generate(proc_table *t, double mean_gap) {
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    double clock = 0;
+    for (size_t i = 0; i < t->n; i++) {
+        if (mean_gap > 0) clock += -mean_gap * log1p(-((xorshift64(&rng) >> 11) * 0x1.0p-53));
+        t->pid[i] = (int64_t)i + 1;
+        t->arrival[i] = (int64_t)clock;
+        t->burst[i] = 1 + (int64_t)(xorshift64(&rng) % MAX_BURST);
+        t->priority[i] = (int64_t)(xorshift64(&rng) % MAX_PRIORITY);
+    }
+}
+
+// The lab programs' way: serial recurrence, float accumulator; returns
+// the average waiting time
+static float lab_style(const proc_table *t) {
+    float twt = 0;
+    int64_t clock = 0;
+    for (size_t i = 0; i < t->n; i++) {
+        if (t->arrival[i] > clock) clock = t->arrival[i];
+        twt += (float)(clock - t->arrival[i]);
+        clock += t->burst[i];
+    }
+    return twt / t->n;
+}
+
+// Straightforward serial version with 64-bit totals, to check against
+static proc_metrics reference(const proc_table *t) {
+    proc_metrics m = { 0, 0, 0, 0 };
+    int64_t clock = 0;
+    for (size_t i = 0; i < t->n; i++) {
+        if (t->arrival[i] > clock) clock = t->arrival[i];
+        int64_t w = clock - t->arrival[i];
+        m.total_wait += w;
+        m.total_turnaround += w + t->burst[i];
+        if (w > m.max_wait) m.max_wait = w;
+        clock += t->burst[i];
+    }
+    m.makespan = clock;
+    return m;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: ./sched_metrics [-n processes] [-t threads] [-a mean_gap] [-p fcfs|sjf|priority|all]\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = DEFAULT_PROCESSES;
+    int threads = 0;
+    double mean_gap = 0;
+    const char *policy = "all";
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage();
+        if (strcmp(argv[i], "-n") == 0) n = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-t") == 0) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-a") == 0) mean_gap = atof(argv[++i]);
+        else if (strcmp(argv[i], "-p") == 0) policy = argv[++i];
+        else usage();
+    }
+    if (n == 0 || mean_gap < 0) usage();
+
+    proc_table t;
+    if (pt_alloc(&t, n) == -1) {
+        fprintf(stderr, "Not enough memory for %zu processes\n", n);
+        return 1;
+    }
+    pf_pool *pool = pf_create(threads);
+    if (!pool) {
+        fprintf(stderr, "Could not start the thread pool\n");
+        return 1;
+    }
+    printf("%zu processes, %d threads, %s arrivals\n\n", n, pf_threads(pool),
+           mean_gap > 0 ? "Poisson" : "all-at-zero");
+    printf("%-9s | %9s | %9s | %9s | %9s | %18s | %12s | %12s | %s\n", "Policy", "Sort (ms)", "Lab (ms)",
+           "Scan (ms)", "Sum (ms)", "Avg wait (exact)", "Avg wait (float)", "Max wait", "Check");
+
+    static const char *names[] = { "fcfs", "sjf", "priority" };
+    for (int p = 0; p < 3; p++) {
+        if (strcmp(policy, "all") != 0 && strcmp(policy, names[p]) != 0) continue;
+        generate(&t, mean_gap);
+
+        // FCFS keeps arrival order; SJF and priority reorder like the labs
+        // (shortest burst first / highest priority value first, ties FCFS)
+        double t0 = now_seconds();
+        if ((p == 1 && pt_sort(&t, t.burst, 0) == -1) || (p == 2 && pt_sort(&t, t.priority, 1) == -1)) {
+            fprintf(stderr, "Not enough memory to sort\n");
+            return 1;
+        }
+        double t1 = now_seconds();
+        float awt = lab_style(&t);
+        double t2 = now_seconds();
+        if (pt_schedule(&t, pool) == -1) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        double t3 = now_seconds();
+        proc_metrics m = pt_metrics(&t, pool);
+        double t4 = now_seconds();
+
+        proc_metrics r = reference(&t);
+        int ok = m.total_wait == r.total_wait && m.total_turnaround == r.total_turnaround &&
+                 m.max_wait == r.max_wait && m.makespan == r.makespan;
+        printf("%-9s | %9.1f | %9.1f | %9.1f | %9.1f | %18.3f | %12.3f | %12lld | %s\n", names[p],
+               (t1 - t0) * 1e3, (t2 - t1) * 1e3, (t3 - t2) * 1e3, (t4 - t3) * 1e3, (double)m.total_wait / n,
+               awt, (long long)m.max_wait, ok ? "ok" : "MISMATCH");
+        if (!ok) return 1;
+    }
+
+    pf_destroy(pool);
+    pt_free(&t);
+    return 0;
+}
@@ -0,0 +1,236 @@
+/*
+ * shm_ring.h - a lock-free single-producer / single-consumer byte ring in
+ * shared memory, for moving data between a parent and a child process.
+ *
+ * hw1.c and part3_pipe_dup2() in lab2.c hand data over with pipe(): every
+ * write() and read() is a system call and every byte is copied into the
+ * kernel and out again. Here both processes map the same memfd:
+ *   - the producer copies straight into the ring and publishes the new
+ *     head with one atomic store, the consumer copies out and publishes
+ *     the tail, so a transfer is one copy on each side and no system call
+ *     while the ring is neither empty nor full,
+ *   - head and tail live on separate cache lines and each side keeps a
+ *     private copy of the other's counter, refreshed only when the ring
+ *     looks full (or empty), so the lines are not bounced on every call,
+ *   - a side that has to wait spins briefly (not at all on a single CPU,
+ *     where the other side cannot run meanwhile) and then sleeps on a futex
+ *     in the shared page; the other side only makes the wake-up system call
+ *     when it sees the waiting flag set.
+ * The calls behave like write() and read() on a blocking pipe, so a
+ * parent/child exchange can switch transports by replacing them:
+ *   shm_ring_create()        map a ring (before fork(); capacity rounds up to a power of 2)
+ *   shm_ring_attach()        map a ring from its fd, e.g. in a program started with exec
+ *   shm_ring_write()         copy all of buf in, waiting for space; -1/EPIPE if the reader is gone
+ *   shm_ring_read()          copy 1..len bytes out, waiting for data; 0 at end of data
+ *   shm_ring_close_writer()  end of data, like closing the write end of a pipe
+ *   shm_ring_close_reader()  the reader is gone; a blocked writer gets EPIPE
+ *   shm_ring_destroy()       unmap and close this process's handle
+ * Exactly one process may write and one may read. As with a pipe, each
+ * side closes its end when it is done, also on error paths, or the peer
+ * waits forever:
+ *   shm_ring r;
+ *   if (shm_ring_create(&r, 1 << 20) == -1) ...
+ *   if (fork() == 0) {                        // child reads, like wc -l
+ *       while ((n = shm_ring_read(&r, buf, sizeof(buf))) > 0) ...
+ *       shm_ring_close_reader(&r);
+ *       shm_ring_destroy(&r);
+ *       _exit(0);
+ *   }
+ *   shm_ring_write(&r, data, len);            // parent writes
+ *   shm_ring_close_writer(&r);                // child's read returns 0
+ *   shm_ring_destroy(&r);
+ *   wait(NULL);
+ *
+ * Header only: #include "shm_ring.h" (Linux: memfd_create and futex).
+ */
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define SHM_RING_LINE 64
+#define SHM_RING_SPIN 256   // polls before going to sleep on the futex (multi-CPU only)
+
+typedef struct {
+    _Atomic uint64_t head;               // bytes ever written; only the producer stores it
+    char pad0[SHM_RING_LINE - sizeof(uint64_t)];
+    _Atomic uint64_t tail;               // bytes ever read; only the consumer stores it
+    char pad1[SHM_RING_LINE - sizeof(uint64_t)];
+    _Atomic uint32_t data_seq;           // futex: bumped when data arrives or the writer closes
+    _Atomic uint32_t space_seq;          // futex: bumped when space frees up or the reader closes
+    _Atomic uint32_t reader_waiting, writer_waiting;
+    _Atomic uint32_t writer_closed, reader_closed;
+    uint64_t capacity;
+} __attribute__((aligned(SHM_RING_LINE))) shm_ring_header;
+
+// Per-process handle
+typedef struct {
+    shm_ring_header *h;
+    unsigned char *data;
+    uint64_t mask;
+    uint64_t seen;      // producer: last tail read; consumer: last head read
+    size_t map_size;
+    int spin;
+    int fd;
+} shm_ring;
+
+static inline void shm_ring_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static inline void shm_ring_sleep(_Atomic uint32_t *word, uint32_t seen) {
+    syscall(SYS_futex, word, FUTEX_WAIT, seen, NULL, NULL, 0);
+}
+
+static inline void shm_ring_wake(_Atomic uint32_t *word) {
+    atomic_fetch_add(word, 1);
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+static inline int shm_ring_map(shm_ring *r, int fd, size_t map_size) {
+    void *p = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return -1;
+    r->h = p;
+    r->data = (unsigned char *)p + sizeof(shm_ring_header);
+    r->mask = r->h->capacity - 1;
+    r->seen = 0;
+    r->map_size = map_size;
+    r->spin = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SHM_RING_SPIN : 0;
+    r->fd = fd;
+    return 0;
+}
+
+// Returns -1 (errno set) if the ring cannot be made
+static inline int shm_ring_create(shm_ring *r, size_t capacity) {
+    uint64_t cap = 4096;
+    while (cap < capacity) cap *= 2;
+    int fd = memfd_create("shm_ring", MFD_CLOEXEC);
+    if (fd == -1) return -1;
+    size_t map_size = sizeof(shm_ring_header) + cap;
+    shm_ring_header init = { .capacity = cap };
+    if (ftruncate(fd, map_size) == -1 || pwrite(fd, &init, sizeof(init), 0) != (ssize_t)sizeof(init) ||
+        shm_ring_map(r, fd, map_size) == -1) {
+        int e = errno;
+        close(fd);
+        errno = e;
+        return -1;
+    }
+    return 0;
+}
+
+// fd must come from shm_ring_create() (clear FD_CLOEXEC to pass it across exec)
+static inline int shm_ring_attach(shm_ring *r, int fd) {
+    struct stat st;
+    if (fstat(fd, &st) == -1) return -1;
+    if ((size_t)st.st_size <= sizeof(shm_ring_header)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return shm_ring_map(r, fd, st.st_size);
+}
+
+static inline ssize_t shm_ring_write(shm_ring *r, const void *buf, size_t len) {
+    shm_ring_header *h = r->h;
+    const unsigned char *src = buf;
+    uint64_t head = atomic_load_explicit(&h->head, memory_order_relaxed);
+    size_t done = 0;
+    while (done < len) {
+        uint64_t space = h->capacity - (head - r->seen);
+        for (int spin = 0; space == 0; spin++) {
+            if (atomic_load(&h->reader_closed)) {
+                if (done) return done;
+                errno = EPIPE;
+                return -1;
+            }
+            r->seen = atomic_load_explicit(&h->tail, memory_order_acquire);
+            space = h->capacity - (head - r->seen);
+            if (space || spin < r->spin) {
+                shm_ring_relax();
+                continue;
+            }
+            // Announce the wait, then look once more: the reader checks the
+            // flag after moving the tail, so one of us sees the other
+            uint32_t seq = atomic_load(&h->space_seq);
+            atomic_store(&h->writer_waiting, 1);
+            r->seen = atomic_load(&h->tail);
+            space = h->capacity - (head - r->seen);
+            if (space == 0 && !atomic_load(&h->reader_closed)) shm_ring_sleep(&h->space_seq, seq);
+            atomic_store(&h->writer_waiting, 0);
+        }
+
+        size_t n = len - done < space ? len - done : space;
+        size_t at = head & r->mask, first = h->capacity - at < n ? h->capacity - at : n;
+        memcpy(r->data + at, src + done, first);
+        memcpy(r->data, src + done + first, n - first);
+        head += n;
+        done += n;
+        atomic_store(&h->head, head);  // seq_cst: ordered before the flag check below
+        if (atomic_load(&h->reader_waiting)) shm_ring_wake(&h->data_seq);
+    }
+    return done;
+}
+
+static inline ssize_t shm_ring_read(shm_ring *r, void *buf, size_t len) {
+    shm_ring_header *h = r->h;
+    uint64_t tail = atomic_load_explicit(&h->tail, memory_order_relaxed);
+    if (len == 0) return 0;
+    for (int spin = 0; r->seen == tail; spin++) {
+        r->seen = atomic_load_explicit(&h->head, memory_order_acquire);
+        if (r->seen != tail) break;
+        if (atomic_load(&h->writer_closed)) {
+            r->seen = atomic_load(&h->head);  // the last bytes may have landed before the close
+            if (r->seen == tail) return 0;
+            break;
+        }
+        if (spin < r->spin) {
+            shm_ring_relax();
+            continue;
+        }
+        uint32_t seq = atomic_load(&h->data_seq);
+        atomic_store(&h->reader_waiting, 1);
+        r->seen = atomic_load(&h->head);
+        if (r->seen == tail && !atomic_load(&h->writer_closed)) shm_ring_sleep(&h->data_seq, seq);
+        atomic_store(&h->reader_waiting, 0);
+    }
+
+    size_t avail = r->seen - tail, n = len < avail ? len : avail;
+    size_t at = tail & r->mask, first = h->capacity - at < n ? h->capacity - at : n;
+    unsigned char *dst = buf;
+    memcpy(dst, r->data + at, first);
+    memcpy(dst + first, r->data, n - first);
+    atomic_store(&h->tail, tail + n);
+    if (atomic_load(&h->writer_waiting)) shm_ring_wake(&h->space_seq);
+    return n;
+}
+
+static inline void shm_ring_close_writer(shm_ring *r) {
+    atomic_store(&r->h->writer_closed, 1);
+    shm_ring_wake(&r->h->data_seq);
+}
+
+static inline void shm_ring_close_reader(shm_ring *r) {
+    atomic_store(&r->h->reader_closed, 1);
+    shm_ring_wake(&r->h->space_seq);
+}
+
+static inline void shm_ring_destroy(shm_ring *r) {
+    munmap(r->h, r->map_size);
+    close(r->fd);
+    r->h = NULL;
+}
+
+#endif
@@ -0,0 +1,335 @@
+/*
+ * Zero-copy file copy utility.
+ *
+ * reversefile.c and the copy/append paths in lab2.c always move data
+ * through a user-space buffer with read()/write(), so every byte is copied
+ * into and back out of the process. For a plain copy the kernel can do the
+ * work itself. This program tries the mechanisms from fastest to slowest
+ * and falls back when one is not supported between the two files:
+ *   1. ioctl(FICLONE)       reflink: shares extents on btrfs/XFS, no data moved
+ *   2. copy_file_range()    in-kernel copy (server-side on NFS/CIFS)
+ *   3. sendfile()           page cache to file without a user buffer
+ *   4. splice()             through a pipe, page references instead of copies
+ *   5. read()/write()       user space, 1MB buffer
+ * A transform (reverse or replace) needs to see the bytes, so it always runs
+ * in user space, through reverse_file and search_replace from this folder.
+ *
+ * Usage: ./zcopy [-m auto|reflink|copy_file_range|sendfile|splice|rw] source dest
+ *        ./zcopy -x reverse source dest
+ *        ./zcopy -x replace pattern replacement source dest
+ * Build: gcc -O2 zcopy.c -o zcopy
+ */
+#define _GNU_SOURCE  // copy_file_range(), splice()
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define RW_BUFFER_SIZE (1024 * 1024)
+#define SPLICE_CHUNK   (1024 * 1024)
+#define MAX_STEP       (1L << 30)   // bytes per copy_file_range()/sendfile() call
+
+enum copy_method { M_AUTO, M_REFLINK, M_COPY_RANGE, M_SENDFILE, M_SPLICE, M_RW, M_COUNT };
+
+static const char *method_names[M_COUNT] = {
+    "auto", "reflink", "copy_file_range", "sendfile", "splice", "rw"
+};
+
+// Each method copies len bytes from in to out (both at offset 0) and
+// returns how many bytes it copied, or -1 with errno set. ENOTSUP-like
+// errors mean "try the next". Fewer than len means the source shrank.
+
+static off_t copy_reflink(int in, int out, off_t len) {
+#ifdef FICLONE
+    return ioctl(out, FICLONE, in) == -1 ? -1 : len;
+#else
+    (void)len;
+    (void)in;
+    (void)out;
+    errno = EOPNOTSUPP;
+    return -1;
+#endif
+}
+
+static off_t copy_range(int in, int out, off_t len) {
+    off_t done = 0;
+    while (done < len) {
+        size_t step = len - done > MAX_STEP ? MAX_STEP : (size_t)(len - done);
+        ssize_t n = copy_file_range(in, NULL, out, NULL, step, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) break;  // source shrank
+        done += n;
+    }
+    return done;
+}
+
+static off_t copy_sendfile(int in, int out, off_t len) {
+    off_t done = 0;
+    while (done < len) {
+        size_t step = len - done > MAX_STEP ? MAX_STEP : (size_t)(len - done);
+        ssize_t n = sendfile(out, in, NULL, step);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) break;
+        done += n;
+    }
+    return done;
+}
+
+static off_t copy_splice(int in, int out, off_t len) {
+    int p[2];
+    if (pipe(p) == -1) return -1;
+    fcntl(p[1], F_SETPIPE_SZ, SPLICE_CHUNK);  // bigger pipe, fewer round trips
+    off_t done = 0;
+    int rc = 0;
+    while (done < len) {
+        size_t step = len - done > SPLICE_CHUNK ? SPLICE_CHUNK : (size_t)(len - done);
+        ssize_t n = splice(in, NULL, p[1], NULL, step, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            rc = n < 0 ? -1 : 0;
+            break;
+        }
+        // Drain exactly what went into the pipe
+        ssize_t left = n;
+        while (left > 0) {
+            ssize_t m = splice(p[0], NULL, out, NULL, left, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (m < 0 && errno == EINTR) continue;
+            if (m <= 0) {
+                rc = -1;
+                break;
+            }
+            left -= m;
+        }
+        if (rc) break;
+        done += n;
+    }
+    int saved = errno;
+    close(p[0]);
+    close(p[1]);
+    errno = saved;
+    return rc ? -1 : done;
+}
+
+static off_t copy_rw(int in, int out, off_t len) {
+    (void)len;
+    char *buf = malloc(RW_BUFFER_SIZE);
+    if (!buf) return -1;
+    ssize_t n;
+    off_t done = 0;
+    int rc = 0;
+    while ((n = read(in, buf, RW_BUFFER_SIZE)) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            rc = -1;
+            break;
+        }
+        char *p = buf;
+        while (n > 0) {
+            ssize_t w = write(out, p, n);
+            if (w < 0 && errno == EINTR) continue;
+            if (w < 0) {
+                rc = -1;
+                break;
+            }
+            p += w;
+            n -= w;
+            done += w;
+        }
+        if (rc) break;
+    }
+    int saved = errno;
+    free(buf);
+    errno = saved;
+    return rc ? -1 : done;
+}
+
+typedef off_t (*copy_fn)(int in, int out, off_t len);
+static const copy_fn methods[M_COUNT] = {
+    NULL, copy_reflink, copy_range, copy_sendfile, copy_splice, copy_rw
+};
+
+// Errors that mean "this mechanism does not work for these two files"
+static int unsupported(int err) {
+    return err == EOPNOTSUPP || err == ENOTSUP || err == EXDEV || err == EINVAL ||
+           err == ENOSYS || err == ENOTTY || err == EBADF || err == EPERM;
+}
+
+// Rewind both files and empty the destination before a (re)try
+static int reset_files(int in, int out) {
+    if (lseek(in, 0, SEEK_SET) == -1 || lseek(out, 0, SEEK_SET) == -1) return -1;
+    return ftruncate(out, 0);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// User + system CPU time of this process, to show how little a kernel copy costs
+static double cpu_seconds(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+// Run one of the transform programs next to this one (argv[0]'s directory)
+static int run_transform(const char *self, char *const args[]) {
+    char path[4096];
+    const char *slash = strrchr(self, '/');
+    int dir_len = slash ? (int)(slash - self + 1) : 0;
+    snprintf(path, sizeof(path), "%.*s%s", dir_len, self, args[0]);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        execv(path, args);
+        execvp(args[0], args);  // not next to us: try $PATH
+        perror("exec transform");
+        _exit(127);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+// Copy source to dest with the requested method (or the first one that
+// works for M_AUTO). Returns the method used, or M_COUNT on failure; *size
+// is the number of bytes actually copied.
+static enum copy_method zero_copy(const char *source, const char *dest, enum copy_method want, off_t *size) {
+    int in = open(source, O_RDONLY);
+    if (in < 0) {
+        perror("Error opening source file");
+        return M_COUNT;
+    }
+    struct stat st;
+    if (fstat(in, &st) == -1) {
+        perror("Error getting source size");
+        close(in);
+        return M_COUNT;
+    }
+    // Not O_TRUNC yet: if dest is source, truncating would destroy it
+    int out = open(dest, O_WRONLY | O_CREAT, st.st_mode & 0777);
+    if (out < 0) {
+        perror("Error opening destination file");
+        close(in);
+        return M_COUNT;
+    }
+    struct stat dest_st;
+    if (fstat(out, &dest_st) == -1 || (dest_st.st_dev == st.st_dev && dest_st.st_ino == st.st_ino)) {
+        fprintf(stderr, "Destination is the source file\n");
+        close(in);
+        close(out);
+        return M_COUNT;
+    }
+    if (ftruncate(out, 0) == -1) {
+        perror("Error truncating destination file");
+        close(in);
+        close(out);
+        return M_COUNT;
+    }
+
+    enum copy_method used = M_COUNT;
+    int first = want == M_AUTO ? M_REFLINK : want;
+    int last = want == M_AUTO ? M_RW : want;
+    *size = 0;
+    for (int m = first; m <= last; m++) {
+        off_t copied = methods[m](in, out, st.st_size);
+        if (copied >= 0) {
+            *size = copied;
+            if (copied < st.st_size) {
+                fprintf(stderr, "%s: short copy, %lld of %lld bytes (source shrank?)\n", method_names[m],
+                        (long long)copied, (long long)st.st_size);
+                break;
+            }
+            used = m;
+            break;
+        }
+        if (!unsupported(errno) || want != M_AUTO) {
+            fprintf(stderr, "%s failed: %s\n", method_names[m], strerror(errno));
+            break;
+        }
+        if (reset_files(in, out) == -1) {
+            perror("Error rewinding files");
+            break;
+        }
+    }
+    if (used != M_COUNT && fsync(out) == -1) {
+        perror("Error syncing destination");
+        used = M_COUNT;
+    }
+    close(in);
+    close(out);
+    return used;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: ./zcopy [-m auto|reflink|copy_file_range|sendfile|splice|rw] source dest\n"
+                    "       ./zcopy -x reverse source dest\n"
+                    "       ./zcopy -x replace pattern replacement source dest\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+    enum copy_method want = M_AUTO;
+    off_t size = 0;
+    int argi = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-x") == 0) {
+        // Transforms have to read every byte, so no zero-copy path applies
+        const char *what = argv[2];
+        double start = now_seconds();
+        int rc;
+        if (strcmp(what, "reverse") == 0 && argc == 5) {
+            char *args[] = { "reverse_file", argv[3], argv[4], NULL };
+            rc = run_transform(argv[0], args);
+        } else if (strcmp(what, "replace") == 0 && argc == 7) {
+            // search_replace edits a file where it lies: clone/copy it in the
+            // kernel first, then let it rewrite only the matches in the copy
+            rc = zero_copy(argv[5], argv[6], M_AUTO, &size) == M_COUNT;
+            if (rc == 0) {
+                char *args[] = { "search_replace", argv[3], argv[4], argv[6], NULL };
+                rc = run_transform(argv[0], args);
+            }
+        } else {
+            usage();
+        }
+        if (rc == 0) printf("Transform '%s' done in %.3f s (user-space path)\n", what, now_seconds() - start);
+        return rc;
+    }
+
+    if (argc > 2 && strcmp(argv[1], "-m") == 0) {
+        want = M_COUNT;
+        for (int m = 0; m < M_COUNT; m++) {
+            if (strcmp(argv[2], method_names[m]) == 0) want = m;
+        }
+        if (want == M_COUNT) usage();
+        argi = 3;
+    }
+    if (argc - argi != 2) usage();
+
+    double start = now_seconds();
+    double cpu_start = cpu_seconds();
+    enum copy_method used = zero_copy(argv[argi], argv[argi + 1], want, &size);
+    if (used == M_COUNT) return 1;
+    double elapsed = now_seconds() - start;
+    double cpu = cpu_seconds() - cpu_start;
+
+    printf("Copied %lld bytes with %s in %.3f s (%.1f MB/s, %.3f s CPU)\n", (long long)size,
+           method_names[used], elapsed, elapsed > 0 ? size / elapsed / 1e6 : 0.0, cpu);
+    return 0;
+}